@@ -0,0 +1,168 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#pragma once
+
+namespace chessMoves {
+
+enum class PieceType : uint8_t
+{
+    Pawn = 0,
+    Rook,
+    Knight,
+    Bishop,
+    Queen,
+    King,
+    None
+};
+
+// the four flag bits of a packed move. bit 2 marks a capture and bit 3 a
+// promotion, a promotion keeps the promoted piece in the two low bits
+enum class MoveFlag : uint8_t
+{
+    Quiet = 0,
+    DoublePawnPush = 1,
+    CastleRight = 2,  // king side, towards the h file
+    CastleLeft = 3,   // queen side, towards the a file
+    Capture = 4,
+    EnPassant = 5,
+    Promotion = 8,
+    PromotionCapture = 12
+};
+
+// which moves a generator produces. captures include every promotion and en
+// passant, quiets are everything else, castling included
+enum class GenType : uint8_t
+{
+    All = 0,
+    Captures,
+    Quiets
+};
+
+// a move packed into 16 bits, the from square in bits 0-5, the to square in
+// bits 6-11 and the flags in bits 12-15. squares use the board numbering of
+// pieceMovements.hpp (0 is a8, 63 is h1). the default constructor leaves the
+// bits uninitialised so a move list does not have to clear its storage
+class boardMove
+{
+    uint16_t m_data;
+
+    static constexpr std::array<PieceType, 4> promotionPieces {PieceType::Knight, PieceType::Bishop, PieceType::Rook, PieceType::Queen};
+
+    static constexpr uint16_t promotionBits(PieceType piece) {
+        switch (piece) {
+            case PieceType::Bishop: return 1;
+            case PieceType::Rook:   return 2;
+            case PieceType::Queen:  return 3;
+            default:                return 0;
+        }
+    }
+
+public:
+    boardMove() = default;
+
+    constexpr boardMove(int from, int to, MoveFlag flag, PieceType promotion = PieceType::None)
+      : m_data(static_cast<uint16_t>(from | (to << 6) | (static_cast<int>(flag) << 12)))
+    {
+        if (flag == MoveFlag::Promotion || flag == MoveFlag::PromotionCapture) {
+            m_data |= static_cast<uint16_t>(promotionBits(promotion) << 12);
+        }
+    }
+
+    constexpr int from() const {
+        return m_data & 0x3f;
+    }
+
+    constexpr int to() const {
+        return (m_data >> 6) & 0x3f;
+    }
+
+    constexpr MoveFlag flag() const {
+        int bits = m_data >> 12;
+        return static_cast<MoveFlag>((bits & 0b1000) ? bits & 0b1100 : bits);
+    }
+
+    constexpr PieceType promotion() const {
+        return isPromotion() ? promotionPieces[(m_data >> 12) & 0b11] : PieceType::None;
+    }
+
+    constexpr bool isCapture() const {
+        return m_data & (0b0100 << 12);
+    }
+
+    constexpr bool isPromotion() const {
+        return m_data & (0b1000 << 12);
+    }
+
+    constexpr uint16_t raw() const {
+        return m_data;
+    }
+
+    // raw 0 is no move, from and to are never the same square in a real one
+    static constexpr boardMove fromRaw(uint16_t data) {
+        boardMove move(0, 0, MoveFlag::Quiet);
+        move.m_data = data;
+        return move;
+    }
+
+    constexpr bool operator==(const boardMove&) const = default;
+};
+
+static_assert(sizeof(boardMove) == 2, "a move is packed into 16 bits");
+
+// fixed capacity list of moves, no legal position has more than 218 moves.
+// aligned to a cache line so a list on the stack starts on its own line, and
+// the storage is left uninitialised until a move is pushed
+struct alignas(64) moveList
+{
+    static constexpr std::size_t capacity = 256;
+
+    std::array<boardMove, capacity> moves;
+    std::size_t count {0};
+
+    void push(boardMove move) {
+#ifdef DEBUG_BUILD
+        if (count == capacity) { throw std::overflow_error("move list overflow, trying to push while at capacity"); }
+#endif
+        moves[count++] = move;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    boardMove& operator[](std::size_t index) {
+        return moves[index];
+    }
+
+    const boardMove& operator[](std::size_t index) const {
+        return moves[index];
+    }
+
+    boardMove* begin() { return moves.data(); }
+    boardMove* end() { return moves.data() + count; }
+    const boardMove* begin() const { return moves.data(); }
+    const boardMove* end() const { return moves.data() + count; }
+};
+
+// coordinate notation as used by perft tools and engines, e.g. e2e4 or e7e8q
+inline std::string
+moveToString(const boardMove& move)
+{
+    auto squareName = [](int place) {
+        return std::string{static_cast<char>('a' + place % 8), static_cast<char>('8' - place / 8)};
+    };
+    std::string result = squareName(move.from()) + squareName(move.to());
+    if (move.isPromotion()) {
+        result += "prnbqk"[static_cast<int>(move.promotion())];
+    }
+    return result;
+}
+}
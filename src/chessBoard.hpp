@@ -0,0 +1,801 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "boardMove.hpp"
+#include "pieceMovements.hpp"
+#include "pieceSquareTables.hpp"
+#include "zobrist.hpp"
+
+#pragma once
+
+inline bool checkFlagsQualified(uint8_t state, uint8_t requiredFlags, uint8_t relevantBits) {
+    state &= relevantBits;
+    requiredFlags &= relevantBits;
+    return (state & requiredFlags) == requiredFlags;
+}
+
+inline std::vector<int> getOnes(uint64_t b) {
+    std::vector<int> ones = {};
+    int count = 0;
+    while (b > 0) {
+        if (b % 2 == 1) {
+            ones.push_back(count);
+        }
+        b /=2;
+        count ++;
+    }
+    return ones;
+}
+
+inline std::vector<std::pair<int, int>> getChessCoordinates(std::vector<int> ones) {
+    std::vector<std::pair<int, int>>   result = {};
+    for (auto p : ones) {
+        int row = p / 8;
+        int col = p % 8;
+        result.push_back({col, row});
+    }
+    return result;
+}
+
+// all the bitboards of one colour, handed to the move generator so it can be
+// written once for both sides
+struct sideBitboards
+{
+    uint64_t pawns;
+    uint64_t rooks;
+    uint64_t knights;
+    uint64_t bishops;
+    uint64_t queens;
+    uint64_t king;
+    uint64_t pieces;
+};
+
+class chessBoard {
+    uint64_t m_pawn_bitshift = 40;
+    uint64_t m_piece_bitshift = 56;
+    uint64_t m_black_pawns = 0xff00;
+    uint64_t m_black_rooks = 0x81;
+    uint64_t m_black_knights = 0x42;
+    uint64_t m_black_bishops = 0x24;
+    uint64_t m_black_queens = 0x8;
+    uint64_t m_black_king = 0x10;
+
+    uint64_t m_white_pawns = m_black_pawns << m_pawn_bitshift;
+    uint64_t m_white_rooks = m_black_rooks << m_piece_bitshift;
+    uint64_t m_white_knights = m_black_knights << m_piece_bitshift;
+    uint64_t m_white_bishops = m_black_bishops << m_piece_bitshift;
+    uint64_t m_white_queens = m_black_queens << m_piece_bitshift;
+    uint64_t m_white_king = m_black_king << m_piece_bitshift;
+
+    uint64_t m_black_pieces = m_black_pawns | m_black_rooks | m_black_knights | m_black_bishops | m_black_queens | m_black_king;
+    uint64_t m_white_pieces = m_white_pawns | m_white_rooks | m_white_knights | m_white_bishops | m_white_queens | m_white_king;
+
+public:
+    // the castling flags are set while that castle is still allowed, right is
+    // the king side (towards the h file) for both colours
+    enum State : uint8_t{
+        WhiteTurn = 0b1,
+        WhiteCastleRight = 0b10,
+        WhiteCastleLeft = 0b100,
+        BlackCastleRight = 0b1000,
+        BlackCastleLeft = 0b10000,
+        HasEnPassant = 0b100000
+    };
+
+private:
+    uint8_t m_board_state = WhiteTurn | WhiteCastleRight | WhiteCastleLeft | BlackCastleRight | BlackCastleLeft;
+
+    // square a pawn can be captured on en passant, only meaningful with HasEnPassant
+    uint8_t m_en_passant_square = 0;
+    uint16_t m_halfmove_clock = 0;
+    uint16_t m_fullmove_number = 1;
+
+    // what makeMove can not work out again from the move itself, pushed by
+    // makeMove and popped by unmakeMove
+    struct undoState
+    {
+        chessMoves::PieceType captured;
+        uint8_t board_state;
+        uint8_t en_passant_square;
+        uint16_t halfmove_clock;
+        chessEval::evalAccumulator eval;
+        uint64_t hash;
+        uint64_t pawn_hash;
+    };
+
+public:
+    // deepest line of moves that can be made on one board before unmaking any
+    static constexpr std::size_t maxUndoDepth = 1024;
+
+private:
+    std::array<undoState, maxUndoDepth> m_undo_stack;
+    std::size_t m_undo_count = 0;
+
+    // zobrist key of the position, kept up to date by makeMove
+    uint64_t m_hash = computeHash();
+
+    // zobrist key of the pawns alone, for caching pawn structure evaluation
+    uint64_t m_pawn_hash = computePawnHash();
+
+    // material and piece-square sums of the position, kept up to date by makeMove
+    chessEval::evalAccumulator m_eval = computeEvaluation();
+
+    using annoying_return_type = std::vector<std::vector<std::pair<int, int>>>;
+
+public:
+    chessBoard() = default;
+
+    // reads a position in Forsyth-Edwards notation, the move counters may be left out
+    explicit chessBoard(std::string_view fen) {
+        uint64_t* boards[12] = {&m_white_pawns, &m_white_rooks, &m_white_knights, &m_white_bishops, &m_white_queens, &m_white_king,
+                                &m_black_pawns, &m_black_rooks, &m_black_knights, &m_black_bishops, &m_black_queens, &m_black_king};
+        for (uint64_t* board : boards) {
+            *board = 0;
+        }
+
+        auto nextField = [&fen]() {
+            while (!fen.empty() && fen.front() == ' ') {
+                fen.remove_prefix(1);
+            }
+            std::size_t end = fen.find(' ');
+            std::string_view field = fen.substr(0, end);
+            fen.remove_prefix(end == std::string_view::npos ? fen.size() : end);
+            return field;
+        };
+
+        std::string_view placement = nextField();
+        int place = 0;
+        for (char c : placement) {
+            if (c == '/') {
+                if (place % 8 != 0) {
+                    throw std::invalid_argument("fen rank does not have eight squares");
+                }
+                continue;
+            }
+            if (c >= '1' && c <= '8') {
+                place += c - '0';
+                continue;
+            }
+            std::size_t index = std::string_view("PRNBQKprnbqk").find(c);
+            if (index == std::string_view::npos || place >= 64) {
+                throw std::invalid_argument(std::string("invalid fen piece placement : ") + std::string(placement));
+            }
+            *boards[index] |= 1ULL << place;
+            ++place;
+        }
+        if (place != 64) {
+            throw std::invalid_argument("fen piece placement does not cover the board");
+        }
+
+        std::string_view sideToMove = nextField();
+        if (sideToMove != "w" && sideToMove != "b") {
+            throw std::invalid_argument("fen side to move must be w or b");
+        }
+        m_board_state = sideToMove == "w" ? WhiteTurn : 0;
+
+        for (char c : nextField()) {
+            switch (c) {
+                case 'K': m_board_state |= WhiteCastleRight; break;
+                case 'Q': m_board_state |= WhiteCastleLeft;  break;
+                case 'k': m_board_state |= BlackCastleRight; break;
+                case 'q': m_board_state |= BlackCastleLeft;  break;
+                case '-': break;
+                default: throw std::invalid_argument("invalid fen castling rights");
+            }
+        }
+
+        std::string_view enPassant = nextField();
+        if (!enPassant.empty() && enPassant != "-") {
+            if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || enPassant[1] < '1' || enPassant[1] > '8') {
+                throw std::invalid_argument("invalid fen en passant square");
+            }
+            m_en_passant_square = static_cast<uint8_t>((enPassant[0] - 'a') + 8 * ('8' - enPassant[1]));
+            m_board_state |= HasEnPassant;
+        }
+
+        std::string_view halfmove = nextField();
+        std::string_view fullmove = nextField();
+        m_halfmove_clock  = halfmove.empty() ? 0 : static_cast<uint16_t>(std::stoi(std::string(halfmove)));
+        m_fullmove_number = fullmove.empty() ? 1 : static_cast<uint16_t>(std::stoi(std::string(fullmove)));
+
+        m_white_pieces = m_white_pawns | m_white_rooks | m_white_knights | m_white_bishops | m_white_queens | m_white_king;
+        m_black_pieces = m_black_pawns | m_black_rooks | m_black_knights | m_black_bishops | m_black_queens | m_black_king;
+        if (__builtin_popcountll(m_white_king) != 1 || __builtin_popcountll(m_black_king) != 1) {
+            throw std::invalid_argument("fen position needs exactly one king per side");
+        }
+        m_hash = computeHash();
+        m_pawn_hash = computePawnHash();
+        m_eval = computeEvaluation();
+    }
+
+    annoying_return_type piecePositions() {
+        annoying_return_type result = {};
+        result.push_back(getChessCoordinates(getOnes(m_white_king)));
+        result.push_back(getChessCoordinates(getOnes(m_white_queens)));
+        result.push_back(getChessCoordinates(getOnes(m_white_bishops)));
+        result.push_back(getChessCoordinates(getOnes(m_white_knights)));
+        result.push_back(getChessCoordinates(getOnes(m_white_rooks)));
+        result.push_back(getChessCoordinates(getOnes(m_white_pawns)));
+
+        result.push_back(getChessCoordinates(getOnes(m_black_king)));
+        result.push_back(getChessCoordinates(getOnes(m_black_queens)));
+        result.push_back(getChessCoordinates(getOnes(m_black_bishops)));
+        result.push_back(getChessCoordinates(getOnes(m_black_knights)));
+        result.push_back(getChessCoordinates(getOnes(m_black_rooks)));
+        result.push_back(getChessCoordinates(getOnes(m_black_pawns)));
+        return result;
+    }
+
+    bool isWhiteTurn() const {
+        return m_board_state & WhiteTurn;
+    }
+
+    sideBitboards side(bool white) const {
+        if (white) {
+            return {m_white_pawns, m_white_rooks, m_white_knights, m_white_bishops, m_white_queens, m_white_king, m_white_pieces};
+        }
+        return {m_black_pawns, m_black_rooks, m_black_knights, m_black_bishops, m_black_queens, m_black_king, m_black_pieces};
+    }
+
+    // every piece of the attacking side that attacks place, sliders see through
+    // nothing but the given occupancy
+    static uint64_t attackersOf(int place, uint64_t occupied, const sideBitboards& attacker, bool attackerIsWhite) {
+        uint64_t pawn_attackers = attackerIsWhite ? chessMoves::blackPawnAttackTable[place] : chessMoves::whitePawnAttackTable[place];
+        return (pawn_attackers & attacker.pawns) |
+               (chessMoves::knightAttackTable[place] & attacker.knights) |
+               (chessMoves::kingAttackTable[place] & attacker.king) |
+               (chessMoves::bishopAttacks(place, occupied) & (attacker.bishops | attacker.queens)) |
+               (chessMoves::rookAttacks(place, occupied) & (attacker.rooks | attacker.queens));
+    }
+
+    // every square the attacking side attacks, whether or not it holds a piece
+    static uint64_t attackedSquares(const sideBitboards& attacker, bool attackerIsWhite, uint64_t occupied) {
+        uint64_t attacked = 0;
+        const std::array<uint64_t, 64>& pawn_table = attackerIsWhite ? chessMoves::whitePawnAttackTable : chessMoves::blackPawnAttackTable;
+        for (uint64_t pawns = attacker.pawns; pawns; pawns &= pawns - 1) {
+            attacked |= pawn_table[__builtin_ctzll(pawns)];
+        }
+        for (uint64_t knights = attacker.knights; knights; knights &= knights - 1) {
+            attacked |= chessMoves::knightAttackTable[__builtin_ctzll(knights)];
+        }
+        for (uint64_t diagonal = attacker.bishops | attacker.queens; diagonal; diagonal &= diagonal - 1) {
+            attacked |= chessMoves::bishopAttacks(__builtin_ctzll(diagonal), occupied);
+        }
+        for (uint64_t straight = attacker.rooks | attacker.queens; straight; straight &= straight - 1) {
+            attacked |= chessMoves::rookAttacks(__builtin_ctzll(straight), occupied);
+        }
+        return attacked | chessMoves::kingAttackTable[__builtin_ctzll(attacker.king)];
+    }
+
+    bool inCheck() const {
+        bool white = isWhiteTurn();
+        sideBitboards us = side(white);
+        return attackersOf(__builtin_ctzll(us.king), m_white_pieces | m_black_pieces, side(!white), !white) != 0;
+    }
+
+    uint64_t hash() const {
+        return m_hash;
+    }
+
+    uint64_t pawnHash() const {
+        return m_pawn_hash;
+    }
+
+    uint16_t halfmoveClock() const {
+        return m_halfmove_clock;
+    }
+
+    // true when the position already occurred since the last capture or pawn
+    // move, found from the keys on the undo stack. positions from before the
+    // board was set up are not known
+    bool isRepetition() const {
+        std::size_t reversible = std::min<std::size_t>(m_halfmove_clock, m_undo_count);
+        for (std::size_t back = 4; back <= reversible; back += 2) {
+            if (m_undo_stack[m_undo_count - back].hash == m_hash) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // moves made and not unmade yet
+    std::size_t undoDepth() const {
+        return m_undo_count;
+    }
+
+    // keeps the last keep moves on the undo stack and forgets the rest, which
+    // can then no longer be unmade or found as repetitions. lets a game longer
+    // than the stack be played move by move on one board
+    void trimHistory(std::size_t keep) {
+        keep = std::min(keep, m_undo_count);
+        std::copy(m_undo_stack.begin() + static_cast<std::ptrdiff_t>(m_undo_count - keep),
+                  m_undo_stack.begin() + static_cast<std::ptrdiff_t>(m_undo_count), m_undo_stack.begin());
+        m_undo_count = keep;
+    }
+
+    // zobrist key of the position built from every bitboard, what hash() has
+    // to agree with after any sequence of makeMove and unmakeMove
+    uint64_t computeHash() const {
+        uint64_t key = isWhiteTurn() ? chessMoves::zobrist.whiteTurn : 0;
+        for (int colour = 0; colour < 2; ++colour) {
+            sideBitboards pieces = side(colour == 0);
+            std::array<uint64_t, 6> boards {pieces.pawns, pieces.rooks, pieces.knights, pieces.bishops, pieces.queens, pieces.king};
+            for (std::size_t piece = 0; piece < boards.size(); ++piece) {
+                for (uint64_t b = boards[piece]; b; b &= b - 1) {
+                    key ^= chessMoves::zobrist.pieceSquare[colour * 6 + piece][__builtin_ctzll(b)];
+                }
+            }
+        }
+        return key ^ stateKey();
+    }
+
+    uint64_t computePawnHash() const {
+        uint64_t key = 0;
+        for (uint64_t b = m_white_pawns; b; b &= b - 1) {
+            key ^= pieceKey(true, chessMoves::PieceType::Pawn, __builtin_ctzll(b));
+        }
+        for (uint64_t b = m_black_pawns; b; b &= b - 1) {
+            key ^= pieceKey(false, chessMoves::PieceType::Pawn, __builtin_ctzll(b));
+        }
+        return key;
+    }
+
+    static uint64_t pieceKey(bool white, chessMoves::PieceType piece, int place) {
+        return chessMoves::zobrist.pieceSquare[(white ? 0 : 6) + static_cast<int>(piece)][place];
+    }
+
+    // the castling and en passant part of the key, the two parts of the state
+    // a move can change in ways that are not a simple toggle
+    uint64_t stateKey() const {
+        uint64_t key = chessMoves::zobrist.castling[(m_board_state >> 1) & 0xf];
+        if (m_board_state & HasEnPassant) {
+            key ^= chessMoves::zobrist.enPassantFile[m_en_passant_square % 8];
+        }
+        return key;
+    }
+
+    // the evaluation sums built from every bitboard, what makeMove and
+    // unmakeMove have to keep m_eval equal to
+    chessEval::evalAccumulator computeEvaluation() const {
+        using chessMoves::PieceType;
+        chessEval::evalAccumulator eval;
+        for (bool white : {true, false}) {
+            sideBitboards pieces = side(white);
+            std::array<uint64_t, 6> boards {pieces.pawns, pieces.rooks, pieces.knights, pieces.bishops, pieces.queens, pieces.king};
+            for (std::size_t piece = 0; piece < boards.size(); ++piece) {
+                for (uint64_t b = boards[piece]; b; b &= b - 1) {
+                    eval.add(white, static_cast<PieceType>(piece), __builtin_ctzll(b));
+                }
+            }
+        }
+        return eval;
+    }
+
+    // material and piece-square score tapered between middlegame and endgame,
+    // from the side to move's point of view
+    // the bonuses are further white minus black scores, blended with the same phase
+    int evaluation(int middlegame_bonus = 0, int endgame_bonus = 0) const {
+        chessEval::evalAccumulator eval = m_eval;
+        eval.middlegame = static_cast<int16_t>(eval.middlegame + middlegame_bonus);
+        eval.endgame = static_cast<int16_t>(eval.endgame + endgame_bonus);
+        int score = eval.blended();
+        return isWhiteTurn() ? score : -score;
+    }
+
+    // recomputes everything makeMove updates incrementally and throws on a
+    // difference. makeMove and unmakeMove call it after every move when
+    // VERIFY_INCREMENTAL is defined, which the unit tests do. it is kept out
+    // of DEBUG_BUILD, the default build, since it makes every move several
+    // times slower and the drivers' nodes per second meaningless
+#if defined(DEBUG_BUILD) || defined(VERIFY_INCREMENTAL)
+    void verifyIncrementalState() const {
+        if (m_hash != computeHash()) { throw std::logic_error("incrementally updated hash differs from the recomputed hash"); }
+        if (m_pawn_hash != computePawnHash()) { throw std::logic_error("incrementally updated pawn hash differs from the recomputed pawn hash"); }
+        if (!(m_eval == computeEvaluation())) { throw std::logic_error("incrementally updated evaluation differs from the recomputed evaluation"); }
+    }
+#endif
+
+    // the rook's from and to squares of a castling move
+    static uint64_t castleRookSquares(chessMoves::boardMove move) {
+        int king_place = move.from();
+        return move.flag() == chessMoves::MoveFlag::CastleRight ? (1ULL << (king_place + 3)) | (1ULL << (king_place + 1))
+                                                               : (1ULL << (king_place - 4)) | (1ULL << (king_place - 1));
+    }
+
+    // a castle is lost once its king or rook moves or the rook is captured
+    static uint8_t castlingRightsLost(uint64_t touched) {
+        uint8_t lost = 0;
+        if (touched & (1ULL << 60)) { lost |= WhiteCastleRight | WhiteCastleLeft; }
+        if (touched & (1ULL << 63)) { lost |= WhiteCastleRight; }
+        if (touched & (1ULL << 56)) { lost |= WhiteCastleLeft; }
+        if (touched & (1ULL << 4))  { lost |= BlackCastleRight | BlackCastleLeft; }
+        if (touched & (1ULL << 7))  { lost |= BlackCastleRight; }
+        if (touched & (1ULL << 0))  { lost |= BlackCastleLeft; }
+        return lost;
+    }
+
+    uint64_t& pieceBitboard(bool white, chessMoves::PieceType piece) {
+        using chessMoves::PieceType;
+        switch (piece) {
+            case PieceType::Pawn:   return white ? m_white_pawns   : m_black_pawns;
+            case PieceType::Rook:   return white ? m_white_rooks   : m_black_rooks;
+            case PieceType::Knight: return white ? m_white_knights : m_black_knights;
+            case PieceType::Bishop: return white ? m_white_bishops : m_black_bishops;
+            case PieceType::Queen:  return white ? m_white_queens  : m_black_queens;
+            case PieceType::King:   return white ? m_white_king    : m_black_king;
+            default: throw std::invalid_argument("no bitboard for an empty square");
+        }
+    }
+
+    chessMoves::PieceType pieceOn(int place, bool white) const {
+        using chessMoves::PieceType;
+        sideBitboards pieces = side(white);
+        uint64_t square = 1ULL << place;
+        if (pieces.pawns & square)   { return PieceType::Pawn; }
+        if (pieces.knights & square) { return PieceType::Knight; }
+        if (pieces.bishops & square) { return PieceType::Bishop; }
+        if (pieces.rooks & square)   { return PieceType::Rook; }
+        if (pieces.queens & square)  { return PieceType::Queen; }
+        if (pieces.king & square)    { return PieceType::King; }
+        return PieceType::None;
+    }
+
+    // plays a legal move from generateMoves. only the bitboards the move touches
+    // are updated, the rest of the state it overwrites goes on the undo stack
+    void makeMove(chessMoves::boardMove move) {
+        using chessMoves::MoveFlag;
+        using chessMoves::PieceType;
+
+#ifdef DEBUG_BUILD
+        if (m_undo_count == maxUndoDepth) { throw std::overflow_error("undo stack overflow, too many moves made without unmaking"); }
+#endif
+        undoState& undo = m_undo_stack[m_undo_count++];
+        undo = {PieceType::None, m_board_state, m_en_passant_square, m_halfmove_clock, m_eval, m_hash, m_pawn_hash};
+        m_hash ^= stateKey() ^ chessMoves::zobrist.whiteTurn;
+
+        bool white = isWhiteTurn();
+        int from = move.from();
+        int to = move.to();
+        uint64_t from_to = (1ULL << from) | (1ULL << to);
+        uint64_t& friendly = white ? m_white_pieces : m_black_pieces;
+        uint64_t& enemies = white ? m_black_pieces : m_white_pieces;
+        PieceType moved = pieceOn(from, white);
+
+        if (move.flag() == MoveFlag::EnPassant) {
+            uint64_t captured_square = 1ULL << (white ? to + 8 : to - 8);
+            undo.captured = PieceType::Pawn;
+            pieceBitboard(!white, PieceType::Pawn) ^= captured_square;
+            enemies ^= captured_square;
+            m_hash ^= pieceKey(!white, PieceType::Pawn, white ? to + 8 : to - 8);
+            m_pawn_hash ^= pieceKey(!white, PieceType::Pawn, white ? to + 8 : to - 8);
+            m_eval.remove(!white, PieceType::Pawn, white ? to + 8 : to - 8);
+        } else if (move.isCapture()) {
+            undo.captured = pieceOn(to, !white);
+            pieceBitboard(!white, undo.captured) ^= 1ULL << to;
+            enemies ^= 1ULL << to;
+            m_hash ^= pieceKey(!white, undo.captured, to);
+            if (undo.captured == PieceType::Pawn) {
+                m_pawn_hash ^= pieceKey(!white, PieceType::Pawn, to);
+            }
+            m_eval.remove(!white, undo.captured, to);
+        }
+
+        PieceType placed = move.isPromotion() ? move.promotion() : moved;
+        pieceBitboard(white, moved) ^= 1ULL << from;
+        pieceBitboard(white, placed) ^= 1ULL << to;
+        friendly ^= from_to;
+        m_hash ^= pieceKey(white, moved, from) ^ pieceKey(white, placed, to);
+        if (moved == PieceType::Pawn) {
+            m_pawn_hash ^= pieceKey(white, PieceType::Pawn, from);
+            if (placed == PieceType::Pawn) {
+                m_pawn_hash ^= pieceKey(white, PieceType::Pawn, to);
+            }
+        }
+        m_eval.remove(white, moved, from);
+        m_eval.add(white, placed, to);
+
+        if (move.flag() == MoveFlag::CastleRight || move.flag() == MoveFlag::CastleLeft) {
+            uint64_t rook_from_to = castleRookSquares(move);
+            pieceBitboard(white, PieceType::Rook) ^= rook_from_to;
+            friendly ^= rook_from_to;
+            m_hash ^= pieceKey(white, PieceType::Rook, __builtin_ctzll(rook_from_to)) ^
+                      pieceKey(white, PieceType::Rook, 63 - __builtin_clzll(rook_from_to));
+            int rook_from = move.flag() == MoveFlag::CastleRight ? from + 3 : from - 4;
+            m_eval.remove(white, PieceType::Rook, rook_from);
+            m_eval.add(white, PieceType::Rook, move.flag() == MoveFlag::CastleRight ? from + 1 : from - 1);
+        }
+
+        m_board_state &= ~(castlingRightsLost(from_to) | HasEnPassant);
+        m_board_state ^= WhiteTurn;
+        if (move.flag() == MoveFlag::DoublePawnPush) {
+            m_board_state |= HasEnPassant;
+            m_en_passant_square = static_cast<uint8_t>((from + to) / 2);
+        }
+        m_hash ^= stateKey();
+
+        m_halfmove_clock = (moved == PieceType::Pawn || move.isCapture()) ? 0 : m_halfmove_clock + 1;
+        if (!white) {
+            ++m_fullmove_number;
+        }
+#ifdef VERIFY_INCREMENTAL
+        verifyIncrementalState();
+#endif
+    }
+
+    // takes back the last move made, which must be the move passed in
+    void unmakeMove(chessMoves::boardMove move) {
+        using chessMoves::MoveFlag;
+        using chessMoves::PieceType;
+
+        const undoState& undo = m_undo_stack[--m_undo_count];
+        m_board_state = undo.board_state;
+        m_en_passant_square = undo.en_passant_square;
+        m_halfmove_clock = undo.halfmove_clock;
+        m_eval = undo.eval;
+        m_hash = undo.hash;
+        m_pawn_hash = undo.pawn_hash;
+
+        bool white = isWhiteTurn();
+        int from = move.from();
+        int to = move.to();
+        uint64_t from_to = (1ULL << from) | (1ULL << to);
+        uint64_t& friendly = white ? m_white_pieces : m_black_pieces;
+        uint64_t& enemies = white ? m_black_pieces : m_white_pieces;
+
+        if (move.isPromotion()) {
+            pieceBitboard(white, move.promotion()) ^= 1ULL << to;
+            pieceBitboard(white, PieceType::Pawn) ^= 1ULL << from;
+        } else {
+            pieceBitboard(white, pieceOn(to, white)) ^= from_to;
+        }
+        friendly ^= from_to;
+
+        if (move.flag() == MoveFlag::CastleRight || move.flag() == MoveFlag::CastleLeft) {
+            uint64_t rook_from_to = castleRookSquares(move);
+            pieceBitboard(white, PieceType::Rook) ^= rook_from_to;
+            friendly ^= rook_from_to;
+        }
+
+        if (undo.captured != PieceType::None) {
+            uint64_t captured_square = 1ULL << (move.flag() == MoveFlag::EnPassant ? (white ? to + 8 : to - 8) : to);
+            pieceBitboard(!white, undo.captured) ^= captured_square;
+            enemies ^= captured_square;
+        }
+
+        if (!white) {
+            --m_fullmove_number;
+        }
+#ifdef VERIFY_INCREMENTAL
+        verifyIncrementalState();
+#endif
+    }
+
+    // the position after a legal move from generateMoves, the board itself is
+    // left as it is. copies the whole board, search and perft use makeMove
+    chessBoard playMove(chessMoves::boardMove move) const {
+        chessBoard next = *this;
+        next.makeMove(move);
+        return next;
+    }
+
+    // one move per target square, a capture when the target holds an enemy piece
+    static void pushTargets(chessMoves::moveList& moves, int from, uint64_t targets, uint64_t enemies) {
+        for (; targets; targets &= targets - 1) {
+            int to = __builtin_ctzll(targets);
+            moves.push({from, to, (enemies >> to) & 1 ? chessMoves::MoveFlag::Capture : chessMoves::MoveFlag::Quiet});
+        }
+    }
+
+    // pawn moves to the last rank are pushed once for each piece they can become
+    static void pushPawnTargets(chessMoves::moveList& moves, int from, uint64_t targets, uint64_t enemies, uint64_t double_push, bool white) {
+        using chessMoves::MoveFlag;
+        using chessMoves::PieceType;
+        uint64_t promotion_rank = white ? 0xffULL : 0xff00000000000000ULL;
+        for (; targets; targets &= targets - 1) {
+            int to = __builtin_ctzll(targets);
+            bool capture = (enemies >> to) & 1;
+            if ((promotion_rank >> to) & 1) {
+                MoveFlag flag = capture ? MoveFlag::PromotionCapture : MoveFlag::Promotion;
+                for (PieceType promotion : {PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight}) {
+                    moves.push({from, to, flag, promotion});
+                }
+            } else {
+                moves.push({from, to, capture ? MoveFlag::Capture : ((double_push >> to) & 1 ? MoveFlag::DoublePawnPush : MoveFlag::Quiet)});
+            }
+        }
+    }
+
+    // knight moves that ignore pins and checks
+    chessMoves::moveList boardKnightMoves() const {
+        bool white = isWhiteTurn();
+        sideBitboards us = side(white);
+        uint64_t enemies = side(!white).pieces;
+
+        chessMoves::moveList moves;
+        for (uint64_t knights = us.knights; knights; knights &= knights - 1) {
+            int place = __builtin_ctzll(knights);
+            pushTargets(moves, place, chessMoves::singleKnightMove(place, enemies, us.pieces), enemies);
+        }
+        return moves;
+    }
+
+    // pawn moves, en passant included, that ignore pins and checks
+    chessMoves::moveList boardPawnMoves() const {
+        bool white = isWhiteTurn();
+        sideBitboards us = side(white);
+        uint64_t enemies = side(!white).pieces;
+        uint64_t empty = ~(us.pieces | enemies);
+        const std::array<uint64_t, 64>& double_table = white ? chessMoves::whitePawnDoublePushTable : chessMoves::blackPawnDoublePushTable;
+        const std::array<uint64_t, 64>& push_table   = white ? chessMoves::whitePawnPushTable : chessMoves::blackPawnPushTable;
+
+        chessMoves::moveList moves;
+        for (uint64_t pawns = us.pawns; pawns; pawns &= pawns - 1) {
+            int place = __builtin_ctzll(pawns);
+            uint64_t targets = white ? chessMoves::singleWhitePawnMove(place, enemies, us.pieces)
+                                     : chessMoves::singleBlackPawnMove(place, enemies, us.pieces);
+            uint64_t double_push = (push_table[place] & empty) ? double_table[place] & empty : 0ULL;
+            pushPawnTargets(moves, place, targets, enemies, double_push, white);
+        }
+        if (m_board_state & HasEnPassant) {
+            uint64_t capturers = (white ? chessMoves::blackPawnAttackTable : chessMoves::whitePawnAttackTable)[m_en_passant_square] & us.pawns;
+            for (; capturers; capturers &= capturers - 1) {
+                moves.push({__builtin_ctzll(capturers), m_en_passant_square, chessMoves::MoveFlag::EnPassant});
+            }
+        }
+        return moves;
+    }
+
+    // generates only legal moves. the checkers, the squares that resolve a
+    // single check and the pin ray of every pinned piece are worked out once up
+    // front, then every piece's targets are masked with them, so no move ever
+    // has to be played and tested for leaving the king in check. type limits
+    // the moves to captures or quiets and from_mask to the pieces on its squares
+    chessMoves::moveList generateMoves(chessMoves::GenType type = chessMoves::GenType::All, uint64_t from_mask = ~0ULL) const {
+        using chessMoves::GenType;
+        using chessMoves::MoveFlag;
+
+        bool white = isWhiteTurn();
+        sideBitboards us = side(white);
+        sideBitboards them = side(!white);
+        uint64_t occupied = us.pieces | them.pieces;
+        int king_place = __builtin_ctzll(us.king);
+
+        chessMoves::moveList moves;
+
+        // promotions are sorted with the captures, they change the material just the same
+        uint64_t promotion_rank = white ? 0xffULL : 0xff00000000000000ULL;
+        uint64_t type_mask = type == GenType::Captures ? them.pieces : (type == GenType::Quiets ? ~them.pieces : ~0ULL);
+        uint64_t pawn_type_mask = type == GenType::Captures ? them.pieces | promotion_rank
+                                : (type == GenType::Quiets ? ~(them.pieces | promotion_rank) : ~0ULL);
+
+        // the king is lifted off the board so it cannot step back along the ray of a slider checking it
+        uint64_t danger = attackedSquares(them, !white, occupied ^ us.king);
+        if (us.king & from_mask) {
+            pushTargets(moves, king_place, chessMoves::kingAttackTable[king_place] & ~us.pieces & ~danger & type_mask, them.pieces);
+        }
+
+        uint64_t checkers = attackersOf(king_place, occupied, them, !white);
+        if (checkers & (checkers - 1)) {
+            // double check, only the king can move
+            return moves;
+        }
+        uint64_t check_mask = checkers ? chessMoves::squaresBetween(king_place, __builtin_ctzll(checkers)) | checkers : ~0ULL;
+        uint64_t target_mask = ~us.pieces & check_mask & type_mask;
+
+        uint64_t pinned = 0;
+        std::array<uint64_t, 64> pin_rays;
+        auto collectPins = [&](uint64_t sliders, auto pinFunction) {
+            for (; sliders; sliders &= sliders - 1) {
+                int slider_place = __builtin_ctzll(sliders);
+                uint64_t ray = pinFunction(slider_place, us.pieces, them.pieces, us.king);
+                uint64_t blockers = ray & us.pieces;
+                if (blockers && !(blockers & (blockers - 1))) {
+                    pinned |= blockers;
+                    pin_rays[__builtin_ctzll(blockers)] = ray | (1ULL << slider_place);
+                }
+            }
+        };
+        collectPins(them.rooks & chessMoves::rookAttacks(king_place, 0), chessMoves::singleRookPin);
+        collectPins(them.bishops & chessMoves::bishopAttacks(king_place, 0), chessMoves::singleBishopPin);
+        collectPins(them.queens & chessMoves::queenAttacks(king_place, 0), chessMoves::singleQueenPin);
+
+        auto allowedSquares = [&pinned, &pin_rays](int place) {
+            return (pinned >> place) & 1 ? pin_rays[place] : ~0ULL;
+        };
+
+        // a pinned knight can never stay on its pin ray
+        for (uint64_t knights = us.knights & ~pinned & from_mask; knights; knights &= knights - 1) {
+            int place = __builtin_ctzll(knights);
+            pushTargets(moves, place, chessMoves::knightAttackTable[place] & target_mask, them.pieces);
+        }
+        for (uint64_t diagonal = (us.bishops | us.queens) & from_mask; diagonal; diagonal &= diagonal - 1) {
+            int place = __builtin_ctzll(diagonal);
+            pushTargets(moves, place, chessMoves::bishopAttacks(place, occupied) & target_mask & allowedSquares(place), them.pieces);
+        }
+        for (uint64_t straight = (us.rooks | us.queens) & from_mask; straight; straight &= straight - 1) {
+            int place = __builtin_ctzll(straight);
+            pushTargets(moves, place, chessMoves::rookAttacks(place, occupied) & target_mask & allowedSquares(place), them.pieces);
+        }
+
+        const std::array<uint64_t, 64>& push_table   = white ? chessMoves::whitePawnPushTable : chessMoves::blackPawnPushTable;
+        const std::array<uint64_t, 64>& double_table = white ? chessMoves::whitePawnDoublePushTable : chessMoves::blackPawnDoublePushTable;
+        const std::array<uint64_t, 64>& attack_table = white ? chessMoves::whitePawnAttackTable : chessMoves::blackPawnAttackTable;
+
+        for (uint64_t pawns = us.pawns & from_mask; pawns; pawns &= pawns - 1) {
+            int place = __builtin_ctzll(pawns);
+            uint64_t allowed = check_mask & allowedSquares(place) & pawn_type_mask;
+            uint64_t single_push = push_table[place] & ~occupied;
+            uint64_t double_push = single_push ? double_table[place] & ~occupied : 0ULL;
+            uint64_t targets = ((single_push | double_push) | (attack_table[place] & them.pieces)) & allowed;
+            pushPawnTargets(moves, place, targets, them.pieces, double_push, white);
+        }
+
+        if ((m_board_state & HasEnPassant) && type != GenType::Quiets) {
+            // two pawns leave the same rank at once, which the pin rays cannot describe,
+            // so each en passant capture is checked by recomputing the attacks on the king
+            int ep_place = m_en_passant_square;
+            int captured_place = white ? ep_place + 8 : ep_place - 8;
+            uint64_t capturers = (white ? chessMoves::blackPawnAttackTable[ep_place] : chessMoves::whitePawnAttackTable[ep_place]) & us.pawns & from_mask;
+            for (; capturers; capturers &= capturers - 1) {
+                int from = __builtin_ctzll(capturers);
+                uint64_t after = occupied ^ (1ULL << from) ^ (1ULL << ep_place) ^ (1ULL << captured_place);
+                sideBitboards remaining = them;
+                remaining.pawns &= ~(1ULL << captured_place);
+                if (attackersOf(king_place, after, remaining, !white) == 0) {
+                    moves.push({from, ep_place, MoveFlag::EnPassant});
+                }
+            }
+        }
+
+        if (!checkers && type != GenType::Captures && (us.king & from_mask)) {
+            // the squares between king and rook must be empty and the squares
+            // the king crosses must not be attacked
+            struct castleRule { State right; int rook_place; uint64_t empty; uint64_t safe; int to; MoveFlag flag; };
+            constexpr std::array<castleRule, 4> castleRules {{
+                {WhiteCastleRight, 63, (1ULL << 61) | (1ULL << 62),               (1ULL << 61) | (1ULL << 62), 62, MoveFlag::CastleRight},
+                {WhiteCastleLeft,  56, (1ULL << 57) | (1ULL << 58) | (1ULL << 59), (1ULL << 58) | (1ULL << 59), 58, MoveFlag::CastleLeft},
+                {BlackCastleRight, 7,  (1ULL << 5) | (1ULL << 6),                 (1ULL << 5) | (1ULL << 6),   6,  MoveFlag::CastleRight},
+                {BlackCastleLeft,  0,  (1ULL << 1) | (1ULL << 2) | (1ULL << 3),   (1ULL << 2) | (1ULL << 3),   2,  MoveFlag::CastleLeft},
+            }};
+            for (std::size_t i = white ? 0 : 2; i < (white ? 2u : 4u); ++i) {
+                const castleRule& rule = castleRules[i];
+                if ((m_board_state & rule.right) && ((us.rooks >> rule.rook_place) & 1) &&
+                    !(occupied & rule.empty) && !(danger & rule.safe)) {
+                    moves.push({king_place, rule.to, rule.flag});
+                }
+            }
+        }
+
+        return moves;
+    }
+
+    // whether a move that was not generated here, say a hash or killer move,
+    // is legal in this position. only the moves of the piece on its from
+    // square are generated
+    bool isLegal(chessMoves::boardMove move) const {
+        for (chessMoves::boardMove legal : generateMoves(chessMoves::GenType::All, 1ULL << move.from())) {
+            if (legal == move) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the legal move written in coordinate notation the way moveToString
+    // writes it, e.g. e2e4 or e7e8q. throws std::invalid_argument when no
+    // legal move is written that way
+    chessMoves::boardMove moveFromString(std::string_view text) const {
+        for (chessMoves::boardMove legal : generateMoves()) {
+            if (chessMoves::moveToString(legal) == text) {
+                return legal;
+            }
+        }
+        throw std::invalid_argument("no legal move " + std::string(text));
+    }
+};
@@ -0,0 +1,77 @@
+#include <array>
+#include <cstdint>
+
+#pragma once
+
+// attack tables for the pieces that jump to a fixed set of squares, built by
+// the compiler. square numbering matches sliderAttacks.hpp, 0 is a8 and 63 is h1,
+// so white pawns move towards lower squares and black pawns towards higher ones.
+// a destination is only added if it is on the board, so nothing can wrap
+// around from the h file to the a file.
+namespace chessMoves {
+
+struct leaperOffset
+{
+    int dx;
+    int dy;
+};
+
+constexpr std::array<leaperOffset, 8> knightOffsets {{
+    {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+}};
+
+constexpr std::array<leaperOffset, 8> kingOffsets {{
+    {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}
+}};
+
+constexpr std::array<leaperOffset, 2> whitePawnCaptureOffsets {{ {-1, -1}, {1, -1} }};
+constexpr std::array<leaperOffset, 2> blackPawnCaptureOffsets {{ {-1, 1}, {1, 1} }};
+constexpr std::array<leaperOffset, 1> whitePawnPushOffsets {{ {0, -1} }};
+constexpr std::array<leaperOffset, 1> blackPawnPushOffsets {{ {0, 1} }};
+
+template<std::size_t N>
+constexpr std::array<uint64_t, 64>
+makeLeaperTable(const std::array<leaperOffset, N>& offsets)
+{
+    std::array<uint64_t, 64> table {};
+    for (int place = 0; place < 64; ++place) {
+        int rank = place / 8;
+        int file = place % 8;
+        for (const leaperOffset& o : offsets) {
+            int r = rank + o.dy;
+            int f = file + o.dx;
+            if (r >= 0 && r <= 7 && f >= 0 && f <= 7) {
+                table[place] |= 1ULL << (f + 8 * r);
+            }
+        }
+    }
+    return table;
+}
+
+// the square two ahead of a pawn still on its starting rank, only reachable
+// when the square in between is empty as well
+constexpr std::array<uint64_t, 64>
+makePawnDoublePushTable(int start_rank, int dy)
+{
+    std::array<uint64_t, 64> table {};
+    for (int file = 0; file < 8; ++file) {
+        table[file + 8 * start_rank] = 1ULL << (file + 8 * (start_rank + 2 * dy));
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 64> knightAttackTable          = makeLeaperTable(knightOffsets);
+constexpr std::array<uint64_t, 64> kingAttackTable            = makeLeaperTable(kingOffsets);
+constexpr std::array<uint64_t, 64> whitePawnAttackTable       = makeLeaperTable(whitePawnCaptureOffsets);
+constexpr std::array<uint64_t, 64> blackPawnAttackTable       = makeLeaperTable(blackPawnCaptureOffsets);
+constexpr std::array<uint64_t, 64> whitePawnPushTable         = makeLeaperTable(whitePawnPushOffsets);
+constexpr std::array<uint64_t, 64> blackPawnPushTable         = makeLeaperTable(blackPawnPushOffsets);
+constexpr std::array<uint64_t, 64> whitePawnDoublePushTable   = makePawnDoublePushTable(6, -1);
+constexpr std::array<uint64_t, 64> blackPawnDoublePushTable   = makePawnDoublePushTable(1, 1);
+
+static_assert(knightAttackTable[0]  == ((1ULL << 10) | (1ULL << 17)), "knight in the corner reaches two squares");
+static_assert(knightAttackTable[7]  == ((1ULL << 13) | (1ULL << 22)), "knight on the h file must not wrap to the a file");
+static_assert(kingAttackTable[63]   == ((1ULL << 62) | (1ULL << 54) | (1ULL << 55)), "king in the corner reaches three squares");
+static_assert(whitePawnAttackTable[48] == (1ULL << 41), "white a pawn only captures towards the b file");
+static_assert(blackPawnAttackTable[15] == (1ULL << 22), "black h pawn only captures towards the g file");
+}
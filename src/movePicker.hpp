@@ -0,0 +1,212 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "boardMove.hpp"
+#include "chessBoard.hpp"
+#include "staticExchange.hpp"
+
+#pragma once
+
+// hands the search one move at a time in the order most likely to cause an
+// early cutoff, generating each group of moves only once the ones before it
+// have been searched. the order is the hash move, the captures by most
+// valuable victim and least valuable attacker, the killer moves, the quiet
+// moves by their history score and last the captures that lose material by
+// static exchange. a node that cuts off on the hash move or a capture never
+// generates its quiet moves at all
+namespace chessSearch {
+
+// how often a quiet move caused a beta cutoff, weighted by depth, indexed by
+// side to move (white 0), from square and to square
+using historyTable = std::array<std::array<std::array<int, 64>, 64>, 2>;
+
+// the two most recent quiet moves that caused a cutoff at one ply
+using killerMoves = std::array<chessMoves::boardMove, 2>;
+
+class movePicker
+{
+public:
+    enum class stage : uint8_t
+    {
+        HashMove = 0,
+        GenerateCaptures,
+        Captures,
+        Killers,
+        GenerateQuiets,
+        Quiets,
+        BadCaptures,
+        Done
+    };
+
+private:
+    // ordering values indexed by PieceType, the king is the worst attacker and
+    // None, the victim of a promotion push, is worth nothing
+    static constexpr std::array<int, 7> orderValues {1, 5, 3, 3, 9, 10, 0};
+
+    const chessBoard& m_board;
+    chessMoves::boardMove m_hash_move;
+    killerMoves m_killers;
+    const historyTable& m_history;
+    stage m_stage {stage::HashMove};
+    bool m_captures_only {false};
+
+    chessMoves::moveList m_moves;
+    std::array<int, chessMoves::moveList::capacity> m_scores;
+    std::size_t m_next {0};
+    std::size_t m_killer_index {0};
+    chessMoves::moveList m_bad_captures;
+    std::size_t m_next_bad {0};
+
+    static bool isNone(chessMoves::boardMove move) {
+        return move.raw() == 0;
+    }
+
+    bool isKiller(chessMoves::boardMove move) const {
+        return move == m_killers[0] || move == m_killers[1];
+    }
+
+    // only a capture by a piece worth more than its victim can lose material,
+    // the static exchange is left out for the rest
+    bool losesMaterial(chessMoves::boardMove move) const {
+        bool white = m_board.isWhiteTurn();
+        chessMoves::PieceType victim = move.flag() == chessMoves::MoveFlag::EnPassant ? chessMoves::PieceType::Pawn
+                                                                                     : m_board.pieceOn(move.to(), !white);
+        int attacker_value = seeValues[static_cast<int>(m_board.pieceOn(move.from(), white))];
+        return !move.isPromotion() && attacker_value > seeValues[static_cast<int>(victim)] && staticExchange(m_board, move) < 0;
+    }
+
+    // most valuable victim first, the cheaper attacker breaks ties. a promotion
+    // counts the piece it becomes as part of the victim
+    int captureScore(chessMoves::boardMove move) const {
+        using chessMoves::PieceType;
+        bool white = m_board.isWhiteTurn();
+        PieceType victim = move.flag() == chessMoves::MoveFlag::EnPassant ? PieceType::Pawn : m_board.pieceOn(move.to(), !white);
+        PieceType attacker = m_board.pieceOn(move.from(), white);
+        int promotion = orderValues[static_cast<int>(move.promotion())];
+        return 16 * (orderValues[static_cast<int>(victim)] + promotion) - orderValues[static_cast<int>(attacker)];
+    }
+
+    // a selection sort step, the best of the moves not yet returned is swapped
+    // forward. cheaper than sorting the whole list when a cutoff comes early
+    chessMoves::boardMove pickBest() {
+        std::size_t best = m_next;
+        for (std::size_t i = m_next + 1; i < m_moves.size(); ++i) {
+            if (m_scores[i] > m_scores[best]) {
+                best = i;
+            }
+        }
+        std::swap(m_moves[m_next], m_moves[best]);
+        std::swap(m_scores[m_next], m_scores[best]);
+        return m_moves[m_next++];
+    }
+
+public:
+    // hash_move may be the previous iteration's move rather than the table's,
+    // and like the killers it may be no move. neither needs to be legal here
+    movePicker(const chessBoard& board, chessMoves::boardMove hash_move, const killerMoves& killers, const historyTable& history)
+      : m_board(board)
+      , m_hash_move(hash_move)
+      , m_killers(killers)
+      , m_history(history) {}
+
+    // the captures and promotions that do not lose material by static
+    // exchange and nothing else, for the quiescence search
+    movePicker(const chessBoard& board, const historyTable& history)
+      : m_board(board)
+      , m_hash_move(chessMoves::boardMove::fromRaw(0))
+      , m_killers {chessMoves::boardMove::fromRaw(0), chessMoves::boardMove::fromRaw(0)}
+      , m_history(history)
+      , m_stage(stage::GenerateCaptures)
+      , m_captures_only(true) {}
+
+    // the next move to search, false once every legal move has been returned
+    bool next(chessMoves::boardMove& move) {
+        switch (m_stage) {
+            case stage::HashMove:
+                m_stage = stage::GenerateCaptures;
+                if (!isNone(m_hash_move) && m_board.isLegal(m_hash_move)) {
+                    move = m_hash_move;
+                    return true;
+                }
+                [[fallthrough]];
+
+            case stage::GenerateCaptures:
+                m_moves = m_board.generateMoves(chessMoves::GenType::Captures);
+                for (std::size_t i = 0; i < m_moves.size(); ++i) {
+                    m_scores[i] = captureScore(m_moves[i]);
+                }
+                m_next = 0;
+                m_stage = stage::Captures;
+                [[fallthrough]];
+
+            case stage::Captures:
+                while (m_next < m_moves.size()) {
+                    move = pickBest();
+                    if (move == m_hash_move) {
+                        continue;
+                    }
+                    if (losesMaterial(move)) {
+                        m_bad_captures.push(move);
+                        continue;
+                    }
+                    return true;
+                }
+                if (m_captures_only) {
+                    m_stage = stage::Done;
+                    return false;
+                }
+                m_stage = stage::Killers;
+                [[fallthrough]];
+
+            case stage::Killers:
+                while (m_killer_index < m_killers.size()) {
+                    move = m_killers[m_killer_index++];
+                    if (!isNone(move) && move != m_hash_move && !move.isCapture() && !move.isPromotion() &&
+                        m_board.isLegal(move)) {
+                        return true;
+                    }
+                }
+                m_stage = stage::GenerateQuiets;
+                [[fallthrough]];
+
+            case stage::GenerateQuiets: {
+                m_moves = m_board.generateMoves(chessMoves::GenType::Quiets);
+                const auto& side_history = m_history[m_board.isWhiteTurn() ? 0 : 1];
+                for (std::size_t i = 0; i < m_moves.size(); ++i) {
+                    m_scores[i] = side_history[m_moves[i].from()][m_moves[i].to()];
+                }
+                m_next = 0;
+                m_stage = stage::Quiets;
+                [[fallthrough]];
+            }
+
+            case stage::Quiets:
+                while (m_next < m_moves.size()) {
+                    move = pickBest();
+                    if (move != m_hash_move && !isKiller(move)) {
+                        return true;
+                    }
+                }
+                m_stage = stage::BadCaptures;
+                [[fallthrough]];
+
+            // kept in the order they were picked, best victim first
+            case stage::BadCaptures:
+                if (m_next_bad < m_bad_captures.size()) {
+                    move = m_bad_captures[m_next_bad++];
+                    return true;
+                }
+                m_stage = stage::Done;
+                [[fallthrough]];
+
+            case stage::Done:
+                return false;
+        }
+        return false;
+    }
+
+    stage currentStage() const {
+        return m_stage;
+    }
+};
+}
@@ -0,0 +1,510 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "boardMove.hpp"
+#include "chessBoard.hpp"
+#include "zobrist.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CHESS_AVX2_BACKEND 1
+#endif
+
+#pragma once
+
+// an efficiently updatable neural network evaluation, an alternative to the
+// tapered piece-square score of chessBoard.
+//
+// the input layer is HalfKP : every non-king piece is a feature relative to
+// the square of one side's king, seen from that side, 64 king squares times
+// 641 piece features. a position only has some thirty active features, so the
+// first layer is kept as two accumulators, one per perspective, holding the
+// sum of the weight rows of every active feature. a move changes at most four
+// features, so nnueEvaluator updates the accumulators with a few row adds and
+// subtracts per move and only rebuilds a perspective when its king moves.
+//
+// the accumulators of the side to move and the other side are clipped to
+// 0..127 and fed through two small int8 layers and an output neuron. both the
+// accumulator updates and the dense layers have an AVX2 version, picked at
+// startup from cpuid like the pext slider tables, and a scalar one that gives
+// bit for bit the same results.
+namespace chessEval {
+
+constexpr int nnuePieceFeatures = 641;                  // 10 piece kinds * 64 squares, plus one unused
+constexpr int nnueInputs = 64 * nnuePieceFeatures;      // 41024
+constexpr int nnueHidden = 256;                         // accumulator width per perspective
+constexpr int nnueLayer2 = 32;
+constexpr int nnueLayer3 = 32;
+constexpr int nnueWeightShift = 6;                      // dense layer sums are scaled down by 64
+constexpr int nnueOutputScale = 16;                     // output units per centipawn
+
+// the weights file starts with this magic and version, then holds every array
+// of nnueNetwork in declaration order, little endian, with nothing in between
+constexpr std::array<char, 4> nnueMagic {'C', 'C', 'N', 'N'};
+constexpr uint32_t nnueVersion = 1;
+
+struct nnueNetwork
+{
+    std::array<int16_t, nnueHidden> featureBias {};
+    std::vector<int16_t> featureWeights = std::vector<int16_t>(static_cast<std::size_t>(nnueInputs) * nnueHidden);
+    std::array<int32_t, nnueLayer2> layer2Bias {};
+    alignas(32) std::array<int8_t, nnueLayer2 * 2 * nnueHidden> layer2Weights {};
+    std::array<int32_t, nnueLayer3> layer3Bias {};
+    alignas(32) std::array<int8_t, nnueLayer3 * nnueLayer2> layer3Weights {};
+    int32_t outputBias {0};
+    alignas(32) std::array<int8_t, nnueLayer3> outputWeights {};
+
+    // throws std::runtime_error when the file cannot be read or is not a network of this shape
+    static std::unique_ptr<nnueNetwork> load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("cannot open network file " + path);
+        }
+        std::array<char, 4> magic {};
+        uint32_t version = 0;
+        uint32_t hidden = 0;
+        file.read(magic.data(), magic.size());
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&hidden), sizeof(hidden));
+        if (!file || magic != nnueMagic || version != nnueVersion || hidden != nnueHidden) {
+            throw std::runtime_error("not a network file of this version and size : " + path);
+        }
+
+        auto network = std::make_unique<nnueNetwork>();
+        forEachArray(*network, [&file](auto* data, std::size_t bytes) {
+            file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(bytes));
+        });
+        if (!file || file.peek() != std::char_traits<char>::eof()) {
+            throw std::runtime_error("network file has the wrong length : " + path);
+        }
+        return network;
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary);
+        uint32_t hidden = nnueHidden;
+        file.write(nnueMagic.data(), nnueMagic.size());
+        file.write(reinterpret_cast<const char*>(&nnueVersion), sizeof(nnueVersion));
+        file.write(reinterpret_cast<const char*>(&hidden), sizeof(hidden));
+        forEachArray(*this, [&file](const auto* data, std::size_t bytes) {
+            file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        });
+        if (!file) {
+            throw std::runtime_error("cannot write network file " + path);
+        }
+    }
+
+    // small random weights, for tests and benchmarks when no trained network is at hand
+    static std::unique_ptr<nnueNetwork> random(uint64_t seed) {
+        auto network = std::make_unique<nnueNetwork>();
+        uint64_t state = seed;
+        auto next = [&state](int range) {
+            return static_cast<int>(chessMoves::splitMix64(state) % static_cast<uint64_t>(2 * range + 1)) - range;
+        };
+        for (int16_t& w : network->featureBias) { w = static_cast<int16_t>(next(64)); }
+        for (int16_t& w : network->featureWeights) { w = static_cast<int16_t>(next(32)); }
+        for (int32_t& w : network->layer2Bias) { w = next(4096); }
+        for (int8_t& w : network->layer2Weights) { w = static_cast<int8_t>(next(127)); }
+        for (int32_t& w : network->layer3Bias) { w = next(4096); }
+        for (int8_t& w : network->layer3Weights) { w = static_cast<int8_t>(next(127)); }
+        network->outputBias = next(4096);
+        for (int8_t& w : network->outputWeights) { w = static_cast<int8_t>(next(127)); }
+        return network;
+    }
+
+private:
+    // the arrays in file order, shared by load and save, which passes a const network
+    template<typename Network, typename Function>
+    static void forEachArray(Network& network, Function&& function) {
+        function(network.featureBias.data(), sizeof(network.featureBias));
+        function(network.featureWeights.data(), network.featureWeights.size() * sizeof(int16_t));
+        function(network.layer2Bias.data(), sizeof(network.layer2Bias));
+        function(network.layer2Weights.data(), sizeof(network.layer2Weights));
+        function(network.layer3Bias.data(), sizeof(network.layer3Bias));
+        function(network.layer3Weights.data(), sizeof(network.layer3Weights));
+        function(&network.outputBias, sizeof(network.outputBias));
+        function(network.outputWeights.data(), sizeof(network.outputWeights));
+    }
+};
+
+// the input feature of a non-king piece as seen from one side. black sees the
+// board flipped, so both sides share the same weights
+inline int
+nnueFeature(bool perspective_white, int king_place, bool piece_white, chessMoves::PieceType piece, int place)
+{
+    int flip = perspective_white ? 0 : 56;
+    int kind = static_cast<int>(piece) * 2 + (piece_white == perspective_white ? 0 : 1);
+    return (king_place ^ flip) * nnuePieceFeatures + 1 + kind * 64 + (place ^ flip);
+}
+
+enum class NnueBackend : int
+{
+    Scalar = 0,
+    Avx2
+};
+
+inline bool
+nnueBackendSupported(NnueBackend backend)
+{
+    if (backend == NnueBackend::Scalar) {
+        return true;
+    }
+#ifdef CHESS_AVX2_BACKEND
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+inline NnueBackend
+detectNnueBackend()
+{
+    return nnueBackendSupported(NnueBackend::Avx2) ? NnueBackend::Avx2 : NnueBackend::Scalar;
+}
+
+inline const char*
+nnueBackendName(NnueBackend backend)
+{
+    return backend == NnueBackend::Avx2 ? "avx2" : "scalar";
+}
+
+inline NnueBackend activeNnueBackend = detectNnueBackend();
+
+// returns false and keeps the current backend if the cpu cannot run the requested one
+inline bool
+setNnueBackend(NnueBackend backend)
+{
+    if (!nnueBackendSupported(backend)) {
+        return false;
+    }
+    activeNnueBackend = backend;
+    return true;
+}
+
+namespace nnueKernels {
+
+// destination = source - every removed row + every added row
+inline void
+updateScalar(int16_t* destination, const int16_t* source, const int16_t* const* added, int added_count,
+             const int16_t* const* removed, int removed_count)
+{
+    for (int i = 0; i < nnueHidden; ++i) {
+        int value = source[i];
+        for (int r = 0; r < removed_count; ++r) {
+            value -= removed[r][i];
+        }
+        for (int a = 0; a < added_count; ++a) {
+            value += added[a][i];
+        }
+        destination[i] = static_cast<int16_t>(value);
+    }
+}
+
+inline void
+clipScalar(uint8_t* destination, const int16_t* source, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        destination[i] = static_cast<uint8_t>(std::clamp<int>(source[i], 0, 127));
+    }
+}
+
+inline void
+affineScalar(int32_t* output, const uint8_t* input, int input_size, const int8_t* weights, const int32_t* bias, int output_size)
+{
+    for (int o = 0; o < output_size; ++o) {
+        int32_t sum = bias[o];
+        const int8_t* row = weights + o * input_size;
+        for (int i = 0; i < input_size; ++i) {
+            sum += input[i] * row[i];
+        }
+        output[o] = sum;
+    }
+}
+
+#ifdef CHESS_AVX2_BACKEND
+__attribute__((target("avx2")))
+inline void
+updateAvx2(int16_t* destination, const int16_t* source, const int16_t* const* added, int added_count,
+           const int16_t* const* removed, int removed_count)
+{
+    for (int i = 0; i < nnueHidden; i += 16) {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        for (int r = 0; r < removed_count; ++r) {
+            value = _mm256_sub_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(removed[r] + i)));
+        }
+        for (int a = 0; a < added_count; ++a) {
+            value = _mm256_add_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(added[a] + i)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), value);
+    }
+}
+
+// saturating packs to int8 then a max with zero clamps to 0..127. the pack
+// works within 128 bit lanes, the permute puts the quarters back in order
+__attribute__((target("avx2")))
+inline void
+clipAvx2(uint8_t* destination, const int16_t* source, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < count; i += 32) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 16));
+        __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(low, high), zero);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_permute4x64_epi64(packed, 0b11011000));
+    }
+}
+
+// maddubs multiplies the unsigned inputs with the signed weights and adds
+// neighbouring pairs into int16. inputs are at most 127, so a pair is at most
+// 2 * 127 * 128 and never saturates, which keeps this equal to the scalar sum
+__attribute__((target("avx2")))
+inline void
+affineAvx2(int32_t* output, const uint8_t* input, int input_size, const int8_t* weights, const int32_t* bias, int output_size)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int o = 0; o < output_size; ++o) {
+        const int8_t* row = weights + o * input_size;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < input_size; i += 32) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones));
+        }
+        __m128i folded = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0b01001110));
+        folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0b10110001));
+        output[o] = bias[o] + _mm_cvtsi128_si32(folded);
+    }
+}
+#endif
+
+inline void
+update(int16_t* destination, const int16_t* source, const int16_t* const* added, int added_count,
+       const int16_t* const* removed, int removed_count)
+{
+#ifdef CHESS_AVX2_BACKEND
+    if (activeNnueBackend == NnueBackend::Avx2) {
+        updateAvx2(destination, source, added, added_count, removed, removed_count);
+        return;
+    }
+#endif
+    updateScalar(destination, source, added, added_count, removed, removed_count);
+}
+
+inline void
+clip(uint8_t* destination, const int16_t* source, int count)
+{
+#ifdef CHESS_AVX2_BACKEND
+    if (activeNnueBackend == NnueBackend::Avx2) {
+        clipAvx2(destination, source, count);
+        return;
+    }
+#endif
+    clipScalar(destination, source, count);
+}
+
+inline void
+affine(int32_t* output, const uint8_t* input, int input_size, const int8_t* weights, const int32_t* bias, int output_size)
+{
+#ifdef CHESS_AVX2_BACKEND
+    if (activeNnueBackend == NnueBackend::Avx2) {
+        affineAvx2(output, input, input_size, weights, bias, output_size);
+        return;
+    }
+#endif
+    affineScalar(output, input, input_size, weights, bias, output_size);
+}
+}
+
+// the first layer of one position, indexed by perspective (white 0, black 1).
+// a perspective whose king moved is rebuilt from the board the next time the
+// position is evaluated, and so is every child of it until then
+struct alignas(64) nnueAccumulator
+{
+    std::array<std::array<int16_t, nnueHidden>, 2> values;
+    std::array<bool, 2> computed {false, false};
+};
+
+// a stack of accumulators that follows a chessBoard through makeMove and
+// unmakeMove. push is called with the board before a move is made, pop after
+// it is taken back. one evaluator per search thread, the network is shared
+class nnueEvaluator
+{
+    const nnueNetwork& m_network;
+    std::vector<nnueAccumulator> m_stack;
+    std::size_t m_top {0};
+
+    const int16_t* row(int feature) const {
+        return m_network.featureWeights.data() + static_cast<std::size_t>(feature) * nnueHidden;
+    }
+
+    // the accumulator of one perspective rebuilt from the bias and the
+    // pieces other than the kings, indexed by side (white 0) and piece type
+    void refresh(nnueAccumulator& accumulator, int perspective, int king_place,
+                 const std::array<std::array<uint64_t, 5>, 2>& boards) {
+        using chessMoves::PieceType;
+        bool perspective_white = perspective == 0;
+        std::array<const int16_t*, 32> added;
+        int added_count = 0;
+        std::copy(m_network.featureBias.begin(), m_network.featureBias.end(), accumulator.values[perspective].begin());
+        for (int side = 0; side < 2; ++side) {
+            for (std::size_t piece = 0; piece < boards[side].size(); ++piece) {
+                for (uint64_t b = boards[side][piece]; b; b &= b - 1) {
+                    added[added_count++] = row(nnueFeature(perspective_white, king_place, side == 0, static_cast<PieceType>(piece), __builtin_ctzll(b)));
+                    if (added_count == static_cast<int>(added.size())) {
+                        nnueKernels::update(accumulator.values[perspective].data(), accumulator.values[perspective].data(),
+                                            added.data(), added_count, nullptr, 0);
+                        added_count = 0;
+                    }
+                }
+            }
+        }
+        nnueKernels::update(accumulator.values[perspective].data(), accumulator.values[perspective].data(), added.data(), added_count, nullptr, 0);
+        accumulator.computed[perspective] = true;
+    }
+
+    static std::array<std::array<uint64_t, 5>, 2> pieceBoards(const chessBoard& board) {
+        std::array<std::array<uint64_t, 5>, 2> boards;
+        for (int side = 0; side < 2; ++side) {
+            sideBitboards pieces = board.side(side == 0);
+            boards[side] = {pieces.pawns, pieces.rooks, pieces.knights, pieces.bishops, pieces.queens};
+        }
+        return boards;
+    }
+
+    void refresh(const chessBoard& board, int perspective) {
+        refresh(m_stack[m_top], perspective, __builtin_ctzll(board.side(perspective == 0).king), pieceBoards(board));
+    }
+
+public:
+    nnueEvaluator(const nnueNetwork& network, const chessBoard& board, std::size_t depth = chessBoard::maxUndoDepth)
+      : m_network(network)
+      , m_stack(depth + 1)
+    {
+        reset(board);
+    }
+
+    // starts over from a new root position
+    void reset(const chessBoard& board) {
+        m_top = 0;
+        refresh(board, 0);
+        refresh(board, 1);
+    }
+
+    void push(const chessBoard& before, chessMoves::boardMove move) {
+        using chessMoves::MoveFlag;
+        using chessMoves::PieceType;
+#ifdef DEBUG_BUILD
+        if (m_top + 1 == m_stack.size()) { throw std::overflow_error("nnue accumulator stack overflow"); }
+#endif
+        bool white = before.isWhiteTurn();
+        int from = move.from();
+        int to = move.to();
+        PieceType moved = before.pieceOn(from, white);
+        PieceType placed = move.isPromotion() ? move.promotion() : moved;
+        PieceType captured = PieceType::None;
+        int captured_place = to;
+        if (move.flag() == MoveFlag::EnPassant) {
+            captured = PieceType::Pawn;
+            captured_place = white ? to + 8 : to - 8;
+        } else if (move.isCapture()) {
+            captured = before.pieceOn(to, !white);
+        }
+
+        const nnueAccumulator& parent = m_stack[m_top];
+        nnueAccumulator& child = m_stack[++m_top];
+        for (int perspective = 0; perspective < 2; ++perspective) {
+            bool perspective_white = perspective == 0;
+            child.computed[perspective] = parent.computed[perspective];
+            if (!child.computed[perspective]) {
+                continue;
+            }
+            // every feature of the mover's perspective hangs on its king
+            // square, so a king move rebuilds that accumulator here, once,
+            // from the pieces as they stand after the move. the moves below
+            // it are incremental again
+            if (moved == PieceType::King && perspective_white == white) {
+                std::array<std::array<uint64_t, 5>, 2> boards = pieceBoards(before);
+                int mover = white ? 0 : 1;
+                if (captured != PieceType::None) {
+                    boards[1 - mover][static_cast<std::size_t>(captured)] &= ~(1ULL << captured_place);
+                }
+                if (move.flag() == MoveFlag::CastleRight || move.flag() == MoveFlag::CastleLeft) {
+                    bool right = move.flag() == MoveFlag::CastleRight;
+                    boards[mover][static_cast<std::size_t>(PieceType::Rook)] ^= (1ULL << (right ? from + 3 : from - 4))
+                                                                               | (1ULL << (right ? from + 1 : from - 1));
+                }
+                refresh(child, perspective, to, boards);
+                continue;
+            }
+            int king_place = __builtin_ctzll(before.side(perspective_white).king);
+            std::array<const int16_t*, 2> added;
+            std::array<const int16_t*, 2> removed;
+            int added_count = 0;
+            int removed_count = 0;
+            if (moved != PieceType::King) {
+                removed[removed_count++] = row(nnueFeature(perspective_white, king_place, white, moved, from));
+                added[added_count++] = row(nnueFeature(perspective_white, king_place, white, placed, to));
+            } else if (move.flag() == MoveFlag::CastleRight || move.flag() == MoveFlag::CastleLeft) {
+                bool right = move.flag() == MoveFlag::CastleRight;
+                removed[removed_count++] = row(nnueFeature(perspective_white, king_place, white, PieceType::Rook, right ? from + 3 : from - 4));
+                added[added_count++] = row(nnueFeature(perspective_white, king_place, white, PieceType::Rook, right ? from + 1 : from - 1));
+            }
+            if (captured != PieceType::None) {
+                removed[removed_count++] = row(nnueFeature(perspective_white, king_place, !white, captured, captured_place));
+            }
+            nnueKernels::update(child.values[perspective].data(), parent.values[perspective].data(),
+                                added.data(), added_count, removed.data(), removed_count);
+        }
+    }
+
+    void pop() {
+        --m_top;
+    }
+
+    // the network's score of board, which must be the position the pushed
+    // moves lead to, from the side to move's point of view in centipawns
+    int evaluate(const chessBoard& board) {
+        nnueAccumulator& accumulator = m_stack[m_top];
+        for (int perspective = 0; perspective < 2; ++perspective) {
+            if (!accumulator.computed[perspective]) {
+                refresh(board, perspective);
+            }
+        }
+
+        int us = board.isWhiteTurn() ? 0 : 1;
+        alignas(32) std::array<uint8_t, 2 * nnueHidden> input;
+        nnueKernels::clip(input.data(), accumulator.values[us].data(), nnueHidden);
+        nnueKernels::clip(input.data() + nnueHidden, accumulator.values[1 - us].data(), nnueHidden);
+
+        alignas(32) std::array<int32_t, nnueLayer2> sums2;
+        alignas(32) std::array<uint8_t, nnueLayer2> hidden2;
+        nnueKernels::affine(sums2.data(), input.data(), 2 * nnueHidden, m_network.layer2Weights.data(), m_network.layer2Bias.data(), nnueLayer2);
+        for (int i = 0; i < nnueLayer2; ++i) {
+            hidden2[i] = static_cast<uint8_t>(std::clamp(sums2[i] >> nnueWeightShift, 0, 127));
+        }
+
+        alignas(32) std::array<int32_t, nnueLayer3> sums3;
+        alignas(32) std::array<uint8_t, nnueLayer3> hidden3;
+        nnueKernels::affine(sums3.data(), hidden2.data(), nnueLayer2, m_network.layer3Weights.data(), m_network.layer3Bias.data(), nnueLayer3);
+        for (int i = 0; i < nnueLayer3; ++i) {
+            hidden3[i] = static_cast<uint8_t>(std::clamp(sums3[i] >> nnueWeightShift, 0, 127));
+        }
+
+        int32_t output;
+        nnueKernels::affine(&output, hidden3.data(), nnueLayer3, m_network.outputWeights.data(), &m_network.outputBias, 1);
+        return output / nnueOutputScale;
+    }
+
+    // the first layer of the current position, rebuilt perspectives included
+    const nnueAccumulator& accumulator() const {
+        return m_stack[m_top];
+    }
+};
+}
@@ -0,0 +1,224 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "chessBoard.hpp"
+#include "leaperAttacks.hpp"
+
+#pragma once
+
+// pawn structure terms of the evaluation : passed, isolated, doubled and
+// backward pawns. they only depend on where the pawns stand, which changes in
+// few of the moves the search makes, so the scores are cached under the
+// board's pawn hash and recomputed only on a miss
+namespace chessEval {
+
+// indexed by the pawn's rank counted from its own side, 0 being the first rank
+constexpr std::array<int, 8> passedMiddlegame {0, 5, 10, 15, 30, 55, 90, 0};
+constexpr std::array<int, 8> passedEndgame {0, 10, 15, 25, 45, 75, 120, 0};
+
+// an endgame bonus for a passed pawn whose next square is empty, which is not
+// cached since it depends on the other pieces
+constexpr std::array<int, 8> freePassedEndgame {0, 0, 3, 6, 12, 20, 30, 0};
+
+constexpr int isolatedMiddlegame = -10;
+constexpr int isolatedEndgame = -15;
+constexpr int doubledMiddlegame = -10;
+constexpr int doubledEndgame = -20;
+constexpr int backwardMiddlegame = -8;
+constexpr int backwardEndgame = -10;
+
+constexpr uint64_t fileABitboard = 0x0101010101010101ULL;
+
+// the squares on the pawn's own file and the files beside it that lie ahead of
+// it, where an enemy pawn keeps it from being passed. indexed by side (white
+// 0) and square
+constexpr std::array<std::array<uint64_t, 64>, 2>
+makePassedMasks()
+{
+    std::array<std::array<uint64_t, 64>, 2> masks {};
+    for (int place = 0; place < 64; ++place) {
+        int file = place & 7;
+        int rank = place >> 3;
+        for (int other = 0; other < 64; ++other) {
+            int other_file = other & 7;
+            int other_rank = other >> 3;
+            if (other_file < file - 1 || other_file > file + 1) {
+                continue;
+            }
+            // white pawns move towards a8, the lower square numbers
+            if (other_rank < rank) {
+                masks[0][place] |= 1ULL << other;
+            }
+            if (other_rank > rank) {
+                masks[1][place] |= 1ULL << other;
+            }
+        }
+    }
+    return masks;
+}
+
+// the squares on the files beside the pawn level with or behind it, where an
+// own pawn could still move up to defend it. indexed by side and square
+constexpr std::array<std::array<uint64_t, 64>, 2>
+makeSupportMasks()
+{
+    std::array<std::array<uint64_t, 64>, 2> masks {};
+    for (int place = 0; place < 64; ++place) {
+        int file = place & 7;
+        int rank = place >> 3;
+        for (int other = 0; other < 64; ++other) {
+            int other_file = other & 7;
+            int other_rank = other >> 3;
+            if (other_file != file - 1 && other_file != file + 1) {
+                continue;
+            }
+            if (other_rank >= rank) {
+                masks[0][place] |= 1ULL << other;
+            }
+            if (other_rank <= rank) {
+                masks[1][place] |= 1ULL << other;
+            }
+        }
+    }
+    return masks;
+}
+
+constexpr std::array<std::array<uint64_t, 64>, 2> passedMasks = makePassedMasks();
+constexpr std::array<std::array<uint64_t, 64>, 2> supportMasks = makeSupportMasks();
+
+static_assert(passedMasks[0][52] == 0x0000383838383838ULL, "a white e2 pawn is passed with no black pawn on d8-f3");
+static_assert(supportMasks[1][12] == 0x0000000000002828ULL, "a black e7 pawn is supported from d7, f7, d8 and f8");
+
+struct pawnEntry
+{
+    uint64_t key {0};
+    int16_t middlegame {0};
+    int16_t endgame {0};
+    // indexed by side, white 0
+    std::array<uint64_t, 2> passed {};
+};
+
+// the structure score of both sides' pawns, white minus black
+inline pawnEntry
+analysePawns(uint64_t white_pawns, uint64_t black_pawns)
+{
+    pawnEntry entry;
+    int middlegame = 0;
+    int endgame = 0;
+    for (int side = 0; side < 2; ++side) {
+        bool white = side == 0;
+        uint64_t own = white ? white_pawns : black_pawns;
+        uint64_t enemy = white ? black_pawns : white_pawns;
+        const std::array<uint64_t, 64>& attack_table = white ? chessMoves::whitePawnAttackTable : chessMoves::blackPawnAttackTable;
+        int sign = white ? 1 : -1;
+
+        for (uint64_t pawns = own; pawns; pawns &= pawns - 1) {
+            int place = __builtin_ctzll(pawns);
+            uint64_t file = fileABitboard << (place & 7);
+            uint64_t ahead = passedMasks[side][place] & file;
+            int rank = white ? 7 - (place >> 3) : place >> 3;
+            int stop = white ? place - 8 : place + 8;
+
+            if (!(passedMasks[side][place] & enemy)) {
+                entry.passed[side] |= 1ULL << place;
+                middlegame += sign * passedMiddlegame[rank];
+                endgame += sign * passedEndgame[rank];
+            }
+            // only the rear pawn of a doubled pair counts, the front one is no worse off
+            if (ahead & own) {
+                middlegame += sign * doubledMiddlegame;
+                endgame += sign * doubledEndgame;
+            }
+            uint64_t neighbour_files = ((file << 1) & ~fileABitboard) | ((file >> 1) & ~(fileABitboard << 7));
+            if (!(neighbour_files & own)) {
+                middlegame += sign * isolatedMiddlegame;
+                endgame += sign * isolatedEndgame;
+            } else if (!(supportMasks[side][place] & own) && (attack_table[stop] & enemy)) {
+                // no pawn beside or behind it can come to its defence and it
+                // cannot advance without being taken
+                middlegame += sign * backwardMiddlegame;
+                endgame += sign * backwardEndgame;
+            }
+        }
+    }
+    entry.middlegame = static_cast<int16_t>(middlegame);
+    entry.endgame = static_cast<int16_t>(endgame);
+    return entry;
+}
+
+// a direct mapped cache of analysePawns by pawn hash. positions in a search
+// tree share a few pawn structures between them, so a small table of its own
+// per search thread hits nearly every time and needs no locking
+class pawnHashTable
+{
+    std::unique_ptr<pawnEntry[]> m_entries;
+    std::size_t m_mask;
+    uint64_t m_probes {0};
+    uint64_t m_hits {0};
+
+public:
+    // entries is rounded down to a power of two. an empty entry has key zero,
+    // the key of a board without pawns, and it is the right analysis of one
+    explicit pawnHashTable(std::size_t entries = 1 << 14) {
+        std::size_t count = 1;
+        while (count * 2 <= entries) {
+            count *= 2;
+        }
+        m_entries = std::make_unique<pawnEntry[]>(count);
+        m_mask = count - 1;
+    }
+
+    const pawnEntry& probe(const chessBoard& board) {
+        uint64_t key = board.pawnHash();
+        pawnEntry& entry = m_entries[key & m_mask];
+        ++m_probes;
+        if (entry.key == key) {
+            ++m_hits;
+            return entry;
+        }
+        entry = analysePawns(board.side(true).pawns, board.side(false).pawns);
+        entry.key = key;
+        return entry;
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i <= m_mask; ++i) {
+            m_entries[i] = pawnEntry {};
+        }
+        m_probes = 0;
+        m_hits = 0;
+    }
+
+    uint64_t probes() const {
+        return m_probes;
+    }
+
+    uint64_t hits() const {
+        return m_hits;
+    }
+};
+
+// the board's material and piece-square score with the pawn structure added,
+// from the side to move's point of view
+inline int
+evaluateWithPawns(const chessBoard& board, pawnHashTable& table)
+{
+    const pawnEntry& pawns = table.probe(board);
+    uint64_t occupied = board.side(true).pieces | board.side(false).pieces;
+    int endgame = pawns.endgame;
+    for (uint64_t passed = pawns.passed[0]; passed; passed &= passed - 1) {
+        int place = __builtin_ctzll(passed);
+        if (!(occupied & (1ULL << (place - 8)))) {
+            endgame += freePassedEndgame[7 - (place >> 3)];
+        }
+    }
+    for (uint64_t passed = pawns.passed[1]; passed; passed &= passed - 1) {
+        int place = __builtin_ctzll(passed);
+        if (!(occupied & (1ULL << (place + 8)))) {
+            endgame -= freePassedEndgame[place >> 3];
+        }
+    }
+    return board.evaluation(pawns.middlegame, endgame);
+}
+}
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "boardMove.hpp"
+#include "chessBoard.hpp"
+
+#pragma once
+
+// counts the leaf nodes of the legal move tree, the standard way of checking a
+// move generator against known node counts and of timing it
+namespace chessPerft {
+
+// caches the node count of every subtree by position hash and remaining
+// depth. transpositions are common deep in the tree, so the same subtree is
+// otherwise counted many times over. a slot is always overwritten by the
+// newest subtree, the count of a deep subtree is only worth anything if it
+// is found again soon.
+//
+// the table can be shared by the parallel perft workers without locks. each
+// slot is two words, the data (node count and depth) and the key xored with
+// the data. a slot torn by two threads writing at once no longer xors back to
+// its key, so it reads as a miss instead of a wrong count
+class perftHashTable
+{
+    struct entry
+    {
+        std::atomic<uint64_t> check {0};
+        std::atomic<uint64_t> data {0};
+    };
+
+    std::unique_ptr<entry[]> m_entries;
+    std::size_t m_size;
+    uint64_t m_index_mask;
+
+public:
+    // the size is rounded down to a power of two entries, at least one
+    explicit perftHashTable(std::size_t megabytes) {
+        std::size_t count = 1;
+        while (count * 2 * sizeof(entry) <= megabytes * 1024 * 1024) {
+            count *= 2;
+        }
+        m_entries = std::make_unique<entry[]>(count);
+        m_size = count;
+        m_index_mask = count - 1;
+    }
+
+    // depth 0 is never stored, so an empty slot can not match
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const {
+        const entry& slot = m_entries[key & m_index_mask];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && static_cast<int>(data & 0xff) == depth) {
+            nodes = data >> 8;
+            return true;
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int depth, uint64_t nodes) {
+        uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth & 0xff);
+        entry& slot = m_entries[key & m_index_mask];
+        slot.check.store(key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+};
+
+struct perftOptions
+{
+    // count the legal moves at depth 1 instead of playing each of them
+    bool bulkCount {false};
+    perftHashTable* hashTable {nullptr};
+    // worker threads for perftDivide, the hash table is shared between them
+    unsigned threads {1};
+};
+
+// plays and takes back every move on the one board it is given
+inline uint64_t
+perftMakeUnmake(chessBoard& board, int depth, const perftOptions& options)
+{
+    if (depth == 0) {
+        return 1;
+    }
+    chessMoves::moveList moves = board.generateMoves();
+    if (depth == 1 && options.bulkCount) {
+        return moves.size();
+    }
+
+    // subtrees one ply deep are cheaper to count again than to look up
+    bool useHash = options.hashTable && depth > 1;
+    uint64_t key = 0;
+    uint64_t nodes = 0;
+    if (useHash) {
+        key = board.hash();
+        if (options.hashTable->probe(key, depth, nodes)) {
+            return nodes;
+        }
+    }
+
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        board.makeMove(moves[i]);
+        nodes += perftMakeUnmake(board, depth - 1, options);
+        board.unmakeMove(moves[i]);
+    }
+
+    if (useHash) {
+        options.hashTable->store(key, depth, nodes);
+    }
+    return nodes;
+}
+
+inline uint64_t
+perft(const chessBoard& board, int depth, const perftOptions& options = {})
+{
+    chessBoard scratch = board;
+    return perftMakeUnmake(scratch, depth, options);
+}
+
+// a subtree still to be counted, nodes found below it are added to the count
+// of the root move it came from
+struct perftTask
+{
+    chessBoard board;
+    int depth;
+    std::size_t rootMove;
+};
+
+// one deque of tasks per worker. the owner takes from the back, where the
+// subtrees it was handed last sit, an idle worker steals from the front of
+// someone else's deque. the tasks are all created up front, so a worker that
+// finds every deque empty is done
+class perftTaskQueues
+{
+    struct queue
+    {
+        std::mutex lock;
+        std::deque<perftTask> tasks;
+    };
+
+    std::vector<queue> m_queues;
+
+public:
+    explicit perftTaskQueues(std::size_t workers) : m_queues(workers) {}
+
+    void push(std::size_t worker, perftTask task) {
+        m_queues[worker].tasks.push_back(std::move(task));
+    }
+
+    bool next(std::size_t worker, perftTask& task) {
+        {
+            queue& own = m_queues[worker];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < m_queues.size(); ++i) {
+            queue& victim = m_queues[(worker + i) % m_queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// node count below each root move, counted by options.threads workers. the
+// tree is split a few plies below the root until there are enough subtrees to
+// keep every worker busy, each task carries its own copy of the board
+inline std::vector<uint64_t>
+perftRootMovesParallel(const chessBoard& board, int depth, const chessMoves::moveList& rootMoves, const perftOptions& options)
+{
+    constexpr std::size_t tasksPerThread = 16;
+    constexpr int maxSplitPlies = 3;
+    std::size_t workers = std::max(1u, options.threads);
+
+    std::vector<perftTask> tasks;
+    for (std::size_t i = 0; i < rootMoves.size(); ++i) {
+        tasks.push_back({board.playMove(rootMoves[i]), depth - 1, i});
+    }
+    // stop splitting where bulk counting would take over, a task should be
+    // worth more than the handful of moves at its leaves
+    int lowestSplitDepth = options.bulkCount ? 2 : 1;
+    for (int ply = 1; ply < maxSplitPlies && tasks.size() < workers * tasksPerThread; ++ply) {
+        std::vector<perftTask> split;
+        for (perftTask& task : tasks) {
+            if (task.depth <= lowestSplitDepth) {
+                split.push_back(std::move(task));
+                continue;
+            }
+            chessMoves::moveList moves = task.board.generateMoves();
+            for (std::size_t i = 0; i < moves.size(); ++i) {
+                split.push_back({task.board.playMove(moves[i]), task.depth - 1, task.rootMove});
+            }
+        }
+        tasks = std::move(split);
+    }
+
+    perftTaskQueues queues(workers);
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        queues.push(i % workers, std::move(tasks[i]));
+    }
+
+    // every worker counts into its own row, summed once they have all finished
+    std::vector<std::vector<uint64_t>> counts(workers, std::vector<uint64_t>(rootMoves.size(), 0));
+    std::vector<std::thread> threads;
+    for (std::size_t worker = 0; worker < workers; ++worker) {
+        threads.emplace_back([&queues, &counts, &options, worker]() {
+            perftTask task {chessBoard(), 0, 0};
+            while (queues.next(worker, task)) {
+                counts[worker][task.rootMove] += perftMakeUnmake(task.board, task.depth, options);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint64_t> rootCounts(rootMoves.size(), 0);
+    for (const std::vector<uint64_t>& row : counts) {
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            rootCounts[i] += row[i];
+        }
+    }
+    return rootCounts;
+}
+
+struct perftResult
+{
+    uint64_t nodes;
+    double seconds;
+
+    double nodesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(nodes) / seconds : 0.0;
+    }
+};
+
+// perft with the node count below every root move printed on its own line
+// ("divide"), which narrows a wrong total down to the move that causes it
+inline perftResult
+perftDivide(const chessBoard& board, int depth, const perftOptions& options = {}, std::ostream& out = std::cout)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    if (depth == 0) {
+        nodes = 1;
+    } else {
+        chessMoves::moveList moves = board.generateMoves();
+        std::vector<uint64_t> rootCounts;
+        if (options.threads > 1) {
+            rootCounts = perftRootMovesParallel(board, depth, moves, options);
+        } else {
+            chessBoard scratch = board;
+            for (std::size_t i = 0; i < moves.size(); ++i) {
+                scratch.makeMove(moves[i]);
+                rootCounts.push_back(perftMakeUnmake(scratch, depth - 1, options));
+                scratch.unmakeMove(moves[i]);
+            }
+        }
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            out << chessMoves::moveToString(moves[i]) << ": " << rootCounts[i] << "\n";
+            nodes += rootCounts[i];
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> elapsed = endTime - startTime;
+    perftResult result {nodes, elapsed.count()};
+    out << "\nnodes : " << result.nodes << "\n"
+        << "time  : " << result.seconds << " s\n"
+        << "nps   : " << static_cast<uint64_t>(result.nodesPerSecond()) << "\n";
+    return result;
+}
+}
@@ -1,288 +1,71 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
-#include <stdexcept>
 #include <sys/types.h>
 #include <utility>
+#include "leaperAttacks.hpp"
+#include "sliderAttacks.hpp"
 #include "stackStack.hpp"
-namespace chessMoves {
-
-enum ScanState
-{
-    hitFriendlyPiece,
-    hitEnemyKing,
-    continueIteration
-};
 
-inline uint64_t
-identityMove(uint64_t)
+#pragma once
 
-inline uint64_t
-blackPawnMove(uint64_t black_pawns, uint64_t enemies, uint64_t friendly)
-{
-    uint64_t enemy_or_empty = ~friendly;
-    uint64_t front_pawn_row = 0xff00;
-    uint64_t black_pawns_move =
-       (((black_pawns << 8) | 
-        ((black_pawns & front_pawn_row) << 16)) & enemy_or_empty) |
-        ((1ULL << 7) & enemies ? (1ULL << 7) : 0ULL) |
-        ((1ULL << 9) & enemies ? (1ULL << 9) : 0ULL);
-    return black_pawns_move;
-}
-
-inline uint64_t
-knightMove(uint64_t knights, uint64_t enemies, uint64_t friendly)
-{
-    uint64_t enemy_or_empty = ~ friendly;
-    uint64_t black_knight_move =
-        ((knights >> 15) + (knights >> 17) | (knights >> 10) | (knights << 6) |
-         (knights >> 6) | (knights << 10) | (knights << 15) | (knights << 17)) &
-        enemy_or_empty;
-    return black_knight_move;
-}
+namespace chessMoves {
 
 inline uint64_t
-whitePawnMove(uint64_t white_pawns, uint64_t enemies, uint64_t friendly)
+identityMove(uint64_t pieces)
 {
-    uint64_t enemy_or_empty = ~friendly;
-    uint64_t front_pawn_row = 0xff000000000000;
-    uint64_t white_pawns_move =
-        ((white_pawns >> 8) |
-        (((white_pawns & front_pawn_row) >> 16) & enemy_or_empty)) |
-        ((1ULL >> 7) & enemies ? (1ULL >> 7) : 0ULL) |
-        ((1ULL >> 9) & enemies ? (1ULL) >> 9 : 0ULL);
-    return white_pawns_move;
-}
-
-inline uint64_t
-_whitePawnMoveEPP(uint64_t white_pawns, uint64_t enemies) {
-    uint64_t ep_capture = 0 | ((white_pawns << 1) & enemies) >> 8 | ((white_pawns >> 1) & enemies) >> 8;
-    return ep_capture;
-}
-
-inline uint64_t 
-_blackPawnMoveEPP(uint64_t black_pawns, uint64_t enemies) {
-    uint64_t ep_capture = 0 | ((black_pawns << 1) & enemies) << 8 | ((black_pawns >> 1) & enemies) << 8;
-    return ep_capture;
-}
-
-inline uint64_t
-whitePawnMoveEPP(uint64_t white_pawns, uint64_t enemies, uint64_t friendly) {
-    return whitePawnMove(white_pawns, enemies, friendly) | _whitePawnMoveEPP(white_pawns, enemies);
+    return pieces;
 }
 
+// the ray from a slider up to, but not including, the enemy king when the king
+// is on one of the slider's lines and none of the slider's own pieces are in
+// the way. enemy pieces on the ray are ignored, so the ray holds exactly one
+// enemy piece when that piece is pinned and none when the slider gives check
+// from a distance. zero when the king is not on one of the slider's lines
 inline uint64_t
-blackPawnMoveEPP(uint64_t black_pawns, uint64_t enemies, uint64_t friendly) {
-    return blackPawnMove(black_pawns, enemies, friendly) | _blackPawnMoveEPP(black_pawns, enemies);
-}
-
-template<typename LoopingFunction>
-uint64_t scanPinRay(uint64_t friendly, uint64_t enemy_king, int rook_rank, int rook_file, int dx, int dy, LoopingFunction loop_checker) {
-
-    auto attack_square =
-        [friendly, enemy_king](uint64_t looking_at) {
-            if (looking_at & enemy_king) {
-                return hitEnemyKing;
-            }
-            if (looking_at & friendly) {
-                return hitFriendlyPiece;
-            }
-            return continueIteration;
-        };
-    
-    uint64_t trial_attack = 0;
-    for (int r = rook_rank + dy, f = rook_file + dx; loop_checker(r,f); r += dy, f += dx) {
-        uint64_t looking_at = 1ULL << (f + 8 * r);
-        ScanState temp = attack_square(looking_at);
-        if (temp == ScanState::continueIteration) {
-            trial_attack |= looking_at;
-        } else if (temp == ScanState::hitFriendlyPiece) {
-            return 0;
-        } else if (temp == ScanState::hitEnemyKing) {
-            return trial_attack;
-        } else {
-            throw std::runtime_error("in _singleRookPin, fell through state if statement, invalid program state\n");
-        }
-    };
-    return 0;
-}
-
-inline uint64_t
-singleRookPin(int rook_place,
-              uint64_t enemy,
-              uint64_t friendly,
-              uint64_t enemy_king)
+sliderPinRay(int slider_place, uint64_t slider_lines, uint64_t friendly, uint64_t enemy_king)
 {
-    int rook_rank = rook_place / 8;
-    int rook_file = rook_place % 8;
-
-    // logic above is correct, below is how I would like the above code to look
-    // but the below code is not logically correct
-    
-    auto innerPinChecker = [friendly, enemy_king, rook_rank, rook_file](int dx, int dy, auto loop_checker) {
-        return scanPinRay(friendly, enemy_king, rook_rank, rook_file, dx, dy, loop_checker);
-    };
-
-
-    return innerPinChecker(1, 0,  [](int r, int f){return (f <= 7);}) 
-         | innerPinChecker(-1,0,  [](int r, int f){return (f >= 0);}) 
-         | innerPinChecker(0, 1,  [](int r, int f){return (r <= 7);})
-         | innerPinChecker(0,-1,  [](int r, int f){return (r >= 0);});
+    if ((slider_lines & enemy_king) == 0) {
+        return 0;
+    }
+    uint64_t ray = squaresBetween(slider_place, __builtin_ctzll(enemy_king));
+    return (ray & friendly) ? 0 : ray;
 }
 
 inline uint64_t
-singleBishopPin(int bishop_place, uint64_t enemy, uint64_t friendly, uint64_t enemy_king) 
+singleRookPin(int rook_place, uint64_t enemy, uint64_t friendly, uint64_t enemy_king)
 {
-    int bishop_rank = bishop_place / 8;
-    int bishop_file = bishop_place % 8;
-
-    auto innerPinChecker = [friendly, enemy_king, bishop_rank, bishop_file](int dx, int dy, auto loop_checker) {
-        return scanPinRay(friendly, enemy_king, bishop_rank, bishop_file, dx, dy, loop_checker);
-    };
-
-    return innerPinChecker(1, 1,  [](int r, int f){return (f <= 7) & (r <= 7) ;})
-         | innerPinChecker(1,-1,  [](int r, int f){return (f <= 7) & (r >= 0) ;})
-         | innerPinChecker(-1,1,  [](int r, int f){return (f >= 0) & (r <= 7) ;})  
-         | innerPinChecker(-1,-1, [](int r, int f){return (f >= 0) & (r >= 0) ;});
+    return sliderPinRay(rook_place, rookAttacks(rook_place, 0), friendly, enemy_king);
 }
 
 inline uint64_t
-singleQueenPin(int queen_place, uint64_t enemy, uint64_t friendly, uint64_t enemy_king) 
+singleBishopPin(int bishop_place, uint64_t enemy, uint64_t friendly, uint64_t enemy_king)
 {
-    int queen_rank = queen_place / 8;
-    int queen_file = queen_place % 8;
-
-    auto innerPinChecker = [friendly, enemy_king, queen_rank, queen_file](int dx, int dy, auto loop_checker) {
-        return scanPinRay(friendly, enemy_king, queen_rank, queen_file, dx, dy, loop_checker);
-    };
-
-    return innerPinChecker(1, 0,  [](int r, int f){return (f <= 7);}) 
-         | innerPinChecker(-1,0,  [](int r, int f){return (f >= 0);}) 
-         | innerPinChecker(0, 1,  [](int r, int f){return (r <= 7);})
-         | innerPinChecker(0,-1,  [](int r, int f){return (r >= 0);})
-         | innerPinChecker(1, 1,  [](int r, int f){return (f <= 7) & (r <= 7) ;})
-         | innerPinChecker(1,-1,  [](int r, int f){return (f <= 7) & (r >= 0) ;})
-         | innerPinChecker(-1,1,  [](int r, int f){return (f >= 0) & (r <= 7) ;})  
-         | innerPinChecker(-1,-1, [](int r, int f){return (f >= 0) & (r >= 0) ;});
+    return sliderPinRay(bishop_place, bishopAttacks(bishop_place, 0), friendly, enemy_king);
 }
 
 inline uint64_t
-_singleRookMove(uint64_t the_ROOOOK,
-                int rook_place,
-                uint64_t enemy,
-                uint64_t friendly)
+singleQueenPin(int queen_place, uint64_t enemy, uint64_t friendly, uint64_t enemy_king)
 {
-    uint64_t attacked_squares = 0;
-
-    int rook_rank = rook_place / 8;
-    int rook_file = rook_place % 8;
-
-    auto attack_square = [&attacked_squares, enemy, friendly](int rr, int ff) {
-        uint64_t looking_at = 1ULL << (ff + 8 * rr);
-        if (looking_at & enemy) {
-            attacked_squares |= looking_at;
-            return true;
-        } else if (looking_at & friendly) {
-            return true;
-        }
-
-        attacked_squares |= looking_at;
-        return false;
-    };
-
-    for (int r = rook_rank, f = rook_file + 1; f <= 7; f++) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-    for (int r = rook_rank, f = rook_file - 1; f >= 0; f--) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-    for (int r = rook_rank + 1, f = rook_file; r <= 7; r++) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-    for (int r = rook_rank - 1, f = rook_file; r >= 0; r--) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-
-    return attacked_squares;
+    return sliderPinRay(queen_place, queenAttacks(queen_place, 0), friendly, enemy_king);
 }
 
 inline uint64_t
 singleRookMove(int rook_place, uint64_t enemy, uint64_t friendly)
 {
-    uint64_t the_ROOOOK = 1ULL << rook_place;
-    uint64_t attacked_squares =
-        _singleRookMove(the_ROOOOK, rook_place, enemy, friendly);
-    return attacked_squares;
+    return rookAttacks(rook_place, enemy | friendly) & ~friendly;
 }
 
 inline uint64_t
-_singleBishopMove(uint64_t the_bishop,
-                  int bishop_place,
-                  uint64_t enemy,
-                  uint64_t friendly)
+singleBishopMove(int bishop_place, uint64_t enemy, uint64_t friendly)
 {
-    uint64_t attacked_squares = 0;
-
-    int bishop_rank = bishop_place / 8;
-    int bishop_file = bishop_place % 8;
-
-    auto attack_square = [&attacked_squares, enemy, friendly](int rr, int ff) {
-        uint64_t looking_at = 1ULL << (ff + 8 * rr);
-        if (looking_at & enemy) {
-            attacked_squares |= looking_at;
-            return true;
-        } else if (looking_at & friendly) {
-            return true;
-        }
-
-        attacked_squares |= looking_at;
-        return false;
-    };
-
-    for (int r = bishop_rank + 1, f = bishop_file + 1; f <= 7 && r <= 7;
-         f++, r++) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-    for (int r = bishop_rank + 1, f = bishop_file - 1; f >= 0 && r <= 7;
-         f--, r++) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-    for (int r = bishop_rank - 1, f = bishop_file + 1; f <= 7 && r >= 0;
-         f++, r--) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-    for (int r = bishop_rank - 1, f = bishop_file - 1; r >= 0 && f >= 0;
-         f--, r--) {
-        if (attack_square(r, f)) {
-            break;
-        };
-    };
-
-    return attacked_squares;
+    return bishopAttacks(bishop_place, enemy | friendly) & ~friendly;
 }
+
 inline uint64_t
-singleBishopMove(int bishop_place, uint64_t enemy, uint64_t friendly)
+singleQueenMove(int queen_place, uint64_t enemy, uint64_t friendly)
 {
-    uint64_t the_bishop = 1ULL << bishop_place;
-
-    uint64_t attacked_squares =
-        _singleBishopMove(the_bishop, bishop_place, enemy, friendly);
-
-    return attacked_squares;
+    return queenAttacks(queen_place, enemy | friendly) & ~friendly;
 }
 
 template<typename Function>
@@ -322,6 +105,86 @@ iterateThroughBitboard_pin(uint64_t pieces,
     return resultBitboard;
 }
 
+// the leapers are a table lookup per piece, the tables already exclude
+// squares off the board so no file wrap masks are needed
+inline uint64_t
+singleKnightMove(int knight_place, uint64_t enemy, uint64_t friendly)
+{
+    return knightAttackTable[knight_place] & ~friendly;
+}
+
+inline uint64_t
+singleKingMove(int king_place, uint64_t enemy, uint64_t friendly)
+{
+    return kingAttackTable[king_place] & ~friendly;
+}
+
+// pawns push onto empty squares only, the double push also needs the square
+// in between to be empty, and they capture diagonally onto enemies only
+inline uint64_t
+singleWhitePawnMove(int pawn_place, uint64_t enemy, uint64_t friendly)
+{
+    uint64_t empty = ~(enemy | friendly);
+    uint64_t single_push = whitePawnPushTable[pawn_place] & empty;
+    uint64_t double_push = single_push ? whitePawnDoublePushTable[pawn_place] & empty : 0ULL;
+    return single_push | double_push | (whitePawnAttackTable[pawn_place] & enemy);
+}
+
+inline uint64_t
+singleBlackPawnMove(int pawn_place, uint64_t enemy, uint64_t friendly)
+{
+    uint64_t empty = ~(enemy | friendly);
+    uint64_t single_push = blackPawnPushTable[pawn_place] & empty;
+    uint64_t double_push = single_push ? blackPawnDoublePushTable[pawn_place] & empty : 0ULL;
+    return single_push | double_push | (blackPawnAttackTable[pawn_place] & enemy);
+}
+
+inline uint64_t
+knightMove(uint64_t knights, uint64_t enemies, uint64_t friendly)
+{
+    return iterateThroughBitboard(knights, enemies, friendly, singleKnightMove);
+}
+
+inline uint64_t
+kingMove(uint64_t kings, uint64_t enemies, uint64_t friendly)
+{
+    return iterateThroughBitboard(kings, enemies, friendly, singleKingMove);
+}
+
+inline uint64_t
+whitePawnMove(uint64_t white_pawns, uint64_t enemies, uint64_t friendly)
+{
+    return iterateThroughBitboard(white_pawns, enemies, friendly, singleWhitePawnMove);
+}
+
+inline uint64_t
+blackPawnMove(uint64_t black_pawns, uint64_t enemies, uint64_t friendly)
+{
+    return iterateThroughBitboard(black_pawns, enemies, friendly, singleBlackPawnMove);
+}
+
+inline uint64_t
+_whitePawnMoveEPP(uint64_t white_pawns, uint64_t enemies) {
+    uint64_t ep_capture = 0 | ((white_pawns << 1) & enemies) >> 8 | ((white_pawns >> 1) & enemies) >> 8;
+    return ep_capture;
+}
+
+inline uint64_t 
+_blackPawnMoveEPP(uint64_t black_pawns, uint64_t enemies) {
+    uint64_t ep_capture = 0 | ((black_pawns << 1) & enemies) << 8 | ((black_pawns >> 1) & enemies) << 8;
+    return ep_capture;
+}
+
+inline uint64_t
+whitePawnMoveEPP(uint64_t white_pawns, uint64_t enemies, uint64_t friendly) {
+    return whitePawnMove(white_pawns, enemies, friendly) | _whitePawnMoveEPP(white_pawns, enemies);
+}
+
+inline uint64_t
+blackPawnMoveEPP(uint64_t black_pawns, uint64_t enemies, uint64_t friendly) {
+    return blackPawnMove(black_pawns, enemies, friendly) | _blackPawnMoveEPP(black_pawns, enemies);
+}
+
 template <size_t N>
 std::pair<std::array<uint64_t, N>, std::size_t> 
 seperateBitboard(uint64_t pieces) {
@@ -350,6 +213,18 @@ rookPins(uint64_t rooks, uint64_t enemy, uint64_t friendly, uint64_t enemy_king)
     return iterateThroughBitboard_pin(rooks, enemy, friendly, singleRookPin, enemy_king);
 }
 
+inline uint64_t
+bishopPins(uint64_t bishops, uint64_t enemy, uint64_t friendly, uint64_t enemy_king)
+{
+    return iterateThroughBitboard_pin(bishops, enemy, friendly, singleBishopPin, enemy_king);
+}
+
+inline uint64_t
+queenPins(uint64_t queens, uint64_t enemy, uint64_t friendly, uint64_t enemy_king)
+{
+    return iterateThroughBitboard_pin(queens, enemy, friendly, singleQueenPin, enemy_king);
+}
+
 inline uint64_t
 rookMove(uint64_t rooks, uint64_t enemy, uint64_t friendly)
 {
@@ -362,13 +237,8 @@ bishopMove(uint64_t bishops, uint64_t enemy, uint64_t friendly)
     return iterateThroughBitboard(bishops, enemy, friendly, singleBishopMove);
 }
 inline uint64_t
-queenMove(uint64_t black_queens, uint64_t enemy, uint64_t friendly)
+queenMove(uint64_t queens, uint64_t enemy, uint64_t friendly)
 {
-    auto singleQueenMove = [](int count, uint64_t friendly, uint64_t enemy) {
-        return singleBishopMove(count, enemy, friendly) |
-               singleRookMove(count, enemy, friendly);
-    };
-    return iterateThroughBitboard(
-        black_queens, enemy, friendly, singleQueenMove);
+    return iterateThroughBitboard(queens, enemy, friendly, singleQueenMove);
 }
 }
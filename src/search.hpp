@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "boardMove.hpp"
+#include "chessBoard.hpp"
+#include "movePicker.hpp"
+#include "nnue.hpp"
+#include "pawnStructure.hpp"
+#include "staticExchange.hpp"
+#include "transpositionTable.hpp"
+
+#pragma once
+
+// iterative deepening negamax alpha-beta search over chessBoard. every
+// iteration searches one ply deeper than the last, starting with the best line
+// found so far, until a depth, node or time limit is reached
+namespace chessSearch {
+
+constexpr int infinityScore = 32000;
+constexpr int mateScore = 31000;
+constexpr int maxPly = 128;
+
+// a score this close to mate is a forced mate within maxPly moves
+inline bool
+isMateScore(int score)
+{
+    return score > mateScore - maxPly || score < -mateScore + maxPly;
+}
+
+// mate scores are stored relative to the node rather than the root, so they
+// stay right when the position is reached again at another ply
+inline int
+scoreToTable(int score, int ply)
+{
+    return score > mateScore - maxPly ? score + ply : (score < -mateScore + maxPly ? score - ply : score);
+}
+
+inline int
+scoreFromTable(int score, int ply)
+{
+    return score > mateScore - maxPly ? score - ply : (score < -mateScore + maxPly ? score + ply : score);
+}
+
+// the incrementally kept material and piece-square score of the board and its
+// cached pawn structure score, from the side to move's point of view
+inline int
+evaluate(const chessBoard& board, chessEval::pawnHashTable& pawns)
+{
+    return chessEval::evaluateWithPawns(board, pawns);
+}
+
+// the game moves a board may hold on its undo stack, the search makes up to
+// maxPly more of its own
+constexpr std::size_t gameHistoryLimit = chessBoard::maxUndoDepth - static_cast<std::size_t>(maxPly);
+
+// makes a move of the game being played, as a front end does with the moves
+// that led to the position to search. once the game fills its share of the
+// undo stack the older moves are dropped, except those since the last capture
+// or pawn move, the only positions that can still repeat
+inline void
+playGameMove(chessBoard& board, chessMoves::boardMove move)
+{
+    if (board.undoDepth() >= gameHistoryLimit) {
+        board.trimHistory(std::min<std::size_t>(board.halfmoveClock(), gameHistoryLimit / 2));
+    }
+    board.makeMove(move);
+}
+
+// a node or time limit of zero is no limit
+struct searchLimits
+{
+    int depth {maxPly - 1};
+    uint64_t nodes {0};
+    std::chrono::milliseconds time {0};
+};
+
+// what a finished iteration found
+struct searchIteration
+{
+    int depth {0};
+    int score {0};
+    uint64_t nodes {0};
+    double seconds {0.0};
+    std::vector<chessMoves::boardMove> pv;
+
+    double nodesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(nodes) / seconds : 0.0;
+    }
+};
+
+// one line per iteration in the style of a uci info line
+inline void
+printIteration(const searchIteration& iteration, std::ostream& out = std::cout)
+{
+    out << "info depth " << iteration.depth << " score ";
+    if (isMateScore(iteration.score)) {
+        int plies = mateScore - (iteration.score > 0 ? iteration.score : -iteration.score);
+        out << "mate " << (iteration.score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+    } else {
+        out << "cp " << iteration.score;
+    }
+    out << " nodes " << iteration.nodes
+        << " nps " << static_cast<uint64_t>(iteration.nodesPerSecond())
+        << " time " << static_cast<uint64_t>(iteration.seconds * 1000.0)
+        << " pv";
+    for (const chessMoves::boardMove& move : iteration.pv) {
+        out << " " << chessMoves::moveToString(move);
+    }
+    out << "\n";
+}
+
+// the state every thread searching the same position shares. nodes are
+// added in batches so the threads do not fight over the counter's cache line
+struct searchShared
+{
+    std::atomic<bool> stop {false};
+    std::atomic<uint64_t> nodes {0};
+    std::chrono::steady_clock::time_point start_time {std::chrono::steady_clock::now()};
+};
+
+class searcher
+{
+    static constexpr uint64_t nodeBatch = 1024;
+
+    chessBoard m_board;
+    searchLimits m_limits;
+    transpositionTable& m_table;
+    searchShared m_own_shared;
+    searchShared& m_shared;
+    uint64_t m_nodes {0};
+    uint64_t m_unshared_nodes {0};
+    bool m_stopped {false};
+
+    // triangular principal variation table, row ply holds the best line found
+    // from that ply on. the previous iteration's line is searched first
+    std::array<std::array<chessMoves::boardMove, maxPly>, maxPly> m_pv {};
+    std::array<int, maxPly> m_pv_length {};
+    std::vector<chessMoves::boardMove> m_previous_pv;
+
+    // move ordering statistics, kept per thread and cleared every search
+    static constexpr int historyLimit = 1 << 20;
+
+    // what a quiet position may gain beyond the captured piece, for delta pruning
+    static constexpr int deltaMargin = 200;
+    std::array<killerMoves, maxPly> m_killers {};
+    historyTable m_history {};
+
+    // the network evaluation replaces the board's own when a network is set
+    std::unique_ptr<chessEval::nnueEvaluator> m_nnue;
+
+    // kept across searches, the pawn structures of the last search are
+    // mostly the ones of the next
+    chessEval::pawnHashTable m_pawns;
+
+    double elapsedSeconds() const {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_shared.start_time;
+        return elapsed.count();
+    }
+
+    void countNode() {
+        ++m_nodes;
+        if (++m_unshared_nodes == nodeBatch) {
+            m_shared.nodes.fetch_add(m_unshared_nodes, std::memory_order_relaxed);
+            m_unshared_nodes = 0;
+        }
+    }
+
+    // any thread that hits a limit stops them all. the clock is only read
+    // every few thousand nodes
+    void checkLimits() {
+        if (m_shared.stop.load(std::memory_order_relaxed)) {
+            m_stopped = true;
+            return;
+        }
+        bool out_of_nodes = m_limits.nodes && totalNodes() >= m_limits.nodes;
+        bool out_of_time = (m_nodes & 2047) == 0 && m_limits.time.count() &&
+                           std::chrono::steady_clock::now() - m_shared.start_time >= m_limits.time;
+        if (out_of_nodes || out_of_time) {
+            m_stopped = true;
+            m_shared.stop.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // quiet moves that cut off are tried early at the same ply as killers, and
+    // earlier everywhere through their history score
+    void rememberCutoff(chessMoves::boardMove move, int depth, int ply) {
+        if (move.isCapture() || move.isPromotion()) {
+            return;
+        }
+        if (m_killers[ply][0] != move) {
+            m_killers[ply][1] = m_killers[ply][0];
+            m_killers[ply][0] = move;
+        }
+        auto& side_history = m_history[m_board.isWhiteTurn() ? 0 : 1];
+        int& score = side_history[move.from()][move.to()];
+        score += depth * depth;
+        if (score > historyLimit) {
+            // halving keeps the relative order while letting newer cutoffs catch up
+            for (auto& row : side_history) {
+                for (int& value : row) {
+                    value /= 2;
+                }
+            }
+        }
+    }
+
+    int staticEvaluation() {
+        return m_nnue ? m_nnue->evaluate(m_board) : evaluate(m_board, m_pawns);
+    }
+
+    void makeMove(chessMoves::boardMove move) {
+        if (m_nnue) {
+            m_nnue->push(m_board, move);
+        }
+        m_board.makeMove(move);
+    }
+
+    void unmakeMove(chessMoves::boardMove move) {
+        m_board.unmakeMove(move);
+        if (m_nnue) {
+            m_nnue->pop();
+        }
+    }
+
+    // searches captures only until the position is quiet, so the leaves of the
+    // main search are not evaluated in the middle of an exchange. the side to
+    // move may stand pat on the static evaluation instead of capturing, except
+    // in check, where every evasion is searched so mates are still seen.
+    // captures that lose material by static exchange are not searched, and
+    // neither are those that cannot bring the score back up to alpha even when
+    // the piece taken is won for free
+    int quiescence(int ply, int alpha, int beta) {
+        m_pv_length[ply] = ply;
+        countNode();
+        checkLimits();
+        if (m_stopped) {
+            return 0;
+        }
+        if (ply >= maxPly - 1) {
+            return staticEvaluation();
+        }
+
+        bool in_check = m_board.inCheck();
+        int best = -infinityScore;
+        int stand_pat = 0;
+        if (!in_check) {
+            stand_pat = staticEvaluation();
+            if (stand_pat >= beta) {
+                return stand_pat;
+            }
+            alpha = std::max(alpha, stand_pat);
+            best = stand_pat;
+        }
+
+        movePicker picker = in_check ? movePicker(m_board, chessMoves::boardMove::fromRaw(0), m_killers[ply], m_history)
+                                     : movePicker(m_board, m_history);
+        bool white = m_board.isWhiteTurn();
+        int searched = 0;
+        chessMoves::boardMove move;
+        while (picker.next(move)) {
+            if (!in_check) {
+                int victim = move.flag() == chessMoves::MoveFlag::EnPassant
+                           ? seeValues[static_cast<int>(chessMoves::PieceType::Pawn)]
+                           : seeValues[static_cast<int>(m_board.pieceOn(move.to(), !white))];
+                int promotion = move.isPromotion() ? seeValues[static_cast<int>(move.promotion())] - seeValues[static_cast<int>(chessMoves::PieceType::Pawn)] : 0;
+                if (stand_pat + victim + promotion + deltaMargin <= alpha) {
+                    continue;
+                }
+            }
+
+            makeMove(move);
+            int score = -quiescence(ply + 1, -beta, -alpha);
+            unmakeMove(move);
+            ++searched;
+            if (m_stopped) {
+                return 0;
+            }
+
+            if (score > best) {
+                best = score;
+            }
+            if (score > alpha) {
+                alpha = score;
+                m_pv[ply][ply] = move;
+                for (int next = ply + 1; next < m_pv_length[ply + 1]; ++next) {
+                    m_pv[ply][next] = m_pv[ply + 1][next];
+                }
+                m_pv_length[ply] = m_pv_length[ply + 1];
+            }
+            if (alpha >= beta) {
+                break;
+            }
+        }
+
+        if (in_check && searched == 0) {
+            return -mateScore + ply;
+        }
+        return best;
+    }
+
+    int negamax(int depth, int ply, int alpha, int beta, bool following_pv) {
+        m_pv_length[ply] = ply;
+        countNode();
+        checkLimits();
+        if (m_stopped) {
+            return 0;
+        }
+
+        if (ply > 0 && (m_board.halfmoveClock() >= 100 || m_board.isRepetition())) {
+            return 0;
+        }
+
+        if (depth <= 0) {
+            return quiescence(ply, alpha, beta);
+        }
+
+        // the root always searches, so there is a best line to report
+        uint64_t key = m_board.hash();
+        ttEntry entry;
+        chessMoves::boardMove hash_move = chessMoves::boardMove::fromRaw(0);
+        if (m_table.probe(key, entry)) {
+            hash_move = entry.move;
+            int table_score = scoreFromTable(entry.score, ply);
+            if (ply > 0 && entry.depth >= depth &&
+                (entry.bound == boundType::Exact ||
+                 (entry.bound == boundType::Lower && table_score >= beta) ||
+                 (entry.bound == boundType::Upper && table_score <= alpha))) {
+                return table_score;
+            }
+        }
+
+        // the previous iteration's line goes first as long as we are still following it
+        if (following_pv && ply < static_cast<int>(m_previous_pv.size())) {
+            hash_move = m_previous_pv[ply];
+        }
+        movePicker picker(m_board, hash_move, m_killers[ply], m_history);
+
+        int original_alpha = alpha;
+        chessMoves::boardMove best_move = chessMoves::boardMove::fromRaw(0);
+        int best = -infinityScore;
+        int searched = 0;
+        chessMoves::boardMove move;
+        while (picker.next(move)) {
+            makeMove(move);
+            int score = -negamax(depth - 1, ply + 1, -beta, -alpha, following_pv && searched == 0);
+            unmakeMove(move);
+            ++searched;
+            if (m_stopped) {
+                return 0;
+            }
+
+            if (score > best) {
+                best = score;
+                best_move = move;
+            }
+            if (score > alpha) {
+                alpha = score;
+                m_pv[ply][ply] = move;
+                for (int next = ply + 1; next < m_pv_length[ply + 1]; ++next) {
+                    m_pv[ply][next] = m_pv[ply + 1][next];
+                }
+                m_pv_length[ply] = m_pv_length[ply + 1];
+            }
+            if (alpha >= beta) {
+                rememberCutoff(move, depth, ply);
+                break;
+            }
+        }
+
+        if (searched == 0) {
+            return m_board.inCheck() ? -mateScore + ply : 0;
+        }
+
+        boundType bound = best >= beta ? boundType::Lower : (best > original_alpha ? boundType::Exact : boundType::Upper);
+        m_table.store(key, {best_move, static_cast<int16_t>(scoreToTable(best, ply)), static_cast<uint8_t>(depth), bound});
+        return best;
+    }
+
+public:
+    // a searcher of its own, the table may still be shared with other searches
+    searcher(const chessBoard& board, searchLimits limits, transpositionTable& table)
+      : m_board(board)
+      , m_limits(limits)
+      , m_table(table)
+      , m_shared(m_own_shared) {}
+
+    // one of several threads searching the same position, see lazySmpSearch
+    searcher(const chessBoard& board, searchLimits limits, transpositionTable& table, searchShared& shared)
+      : m_board(board)
+      , m_limits(limits)
+      , m_table(table)
+      , m_shared(shared) {}
+
+    // evaluates with the network rather than the piece-square tables. the
+    // network is shared, it has to outlive the searcher
+    void setNetwork(const chessEval::nnueNetwork& network) {
+        m_nnue = std::make_unique<chessEval::nnueEvaluator>(network, m_board, maxPly);
+    }
+
+    searcher(const searcher&) = delete;
+    searcher& operator=(const searcher&) = delete;
+
+    // searches until a limit is hit, reporting every finished iteration. the
+    // returned iteration is the deepest finished one. helpers (helper_index
+    // above zero) with an odd index search one ply deeper each iteration than
+    // the others, so the threads spread over different parts of the tree
+    // instead of all searching the same nodes in step
+    searchIteration run(const std::function<void(const searchIteration&)>& report = {}, int helper_index = 0) {
+        if (&m_shared == &m_own_shared) {
+            m_own_shared.stop.store(false, std::memory_order_relaxed);
+            m_own_shared.nodes.store(0, std::memory_order_relaxed);
+            m_own_shared.start_time = std::chrono::steady_clock::now();
+            m_table.newSearch();
+        }
+        m_nodes = 0;
+        m_unshared_nodes = 0;
+        m_stopped = false;
+        m_previous_pv.clear();
+        m_killers.fill({chessMoves::boardMove::fromRaw(0), chessMoves::boardMove::fromRaw(0)});
+        m_history = {};
+        if (m_nnue) {
+            m_nnue->reset(m_board);
+        }
+
+        searchIteration best;
+        chessMoves::moveList rootMoves = m_board.generateMoves();
+        if (rootMoves.empty()) {
+            best.score = m_board.inCheck() ? -mateScore : 0;
+            return best;
+        }
+        // whatever happens there is a legal move to play
+        best.pv = {rootMoves[0]};
+
+        int depth_offset = helper_index % 2;
+        for (int depth = 1 + depth_offset; depth <= m_limits.depth && depth < maxPly; ++depth) {
+            int score = negamax(depth, 0, -infinityScore, infinityScore, true);
+            if (m_stopped) {
+                // a cut short first iteration still beats no move at all
+                if (depth == 1 && m_pv_length[0] > 0) {
+                    best.pv.assign(m_pv[0].begin(), m_pv[0].begin() + m_pv_length[0]);
+                }
+                break;
+            }
+
+            best.depth = depth;
+            best.score = score;
+            best.nodes = totalNodes();
+            best.seconds = elapsedSeconds();
+            best.pv.assign(m_pv[0].begin(), m_pv[0].begin() + m_pv_length[0]);
+            m_previous_pv = best.pv;
+            if (report) {
+                report(best);
+            }
+
+            // nothing deeper can find a shorter mate
+            if (isMateScore(score) && mateScore - std::abs(score) <= depth) {
+                break;
+            }
+        }
+        m_shared.nodes.fetch_add(m_unshared_nodes, std::memory_order_relaxed);
+        m_unshared_nodes = 0;
+        return best;
+    }
+
+    // nodes searched by this thread
+    uint64_t nodes() const {
+        return m_nodes;
+    }
+
+    const chessEval::pawnHashTable& pawnTable() const {
+        return m_pawns;
+    }
+
+    // nodes searched by every thread on this position, the other threads' last
+    // unshared batch is not counted yet
+    uint64_t totalNodes() const {
+        return m_shared.nodes.load(std::memory_order_relaxed) + m_unshared_nodes;
+    }
+};
+
+// lazy smp : every thread runs its own iterative deepening search of the same
+// position on its own copy of the board. they share nothing but the
+// transposition table and the stop flag, and speed each other up through the
+// table entries the others leave behind. the first thread reports and decides
+// the move, once it is done the helpers are stopped. with a network every
+// thread evaluates with it, through an accumulator stack of its own.
+//
+// shared has to be fresh for every search. a caller that owns it can stop
+// the search from another thread by setting its stop flag
+inline searchIteration
+lazySmpSearch(const chessBoard& board, searchLimits limits, transpositionTable& table, unsigned threads, searchShared& shared,
+              const std::function<void(const searchIteration&)>& report = {}, const chessEval::nnueNetwork* network = nullptr)
+{
+    table.newSearch();
+
+    std::vector<std::unique_ptr<searcher>> searchers;
+    for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+        searchers.push_back(std::make_unique<searcher>(board, limits, table, shared));
+        if (network) {
+            searchers.back()->setNetwork(*network);
+        }
+    }
+
+    std::vector<std::thread> helpers;
+    for (std::size_t i = 1; i < searchers.size(); ++i) {
+        helpers.emplace_back([&searchers, i]() {
+            searchers[i]->run({}, static_cast<int>(i));
+        });
+    }
+
+    searchIteration result = searchers[0]->run(report);
+    shared.stop.store(true, std::memory_order_relaxed);
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    // the whole search rather than the last finished iteration, so the node
+    // rate covers the work of every thread
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - shared.start_time;
+    result.nodes = shared.nodes.load(std::memory_order_relaxed);
+    result.seconds = elapsed.count();
+    return result;
+}
+
+inline searchIteration
+lazySmpSearch(const chessBoard& board, searchLimits limits, transpositionTable& table, unsigned threads,
+              const std::function<void(const searchIteration&)>& report = {}, const chessEval::nnueNetwork* network = nullptr)
+{
+    searchShared shared;
+    return lazySmpSearch(board, limits, table, threads, shared, report, network);
+}
+}
@@ -0,0 +1,324 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CHESS_PEXT_BACKEND 1
+#endif
+
+#pragma once
+
+// magic bitboard attack tables for the sliding pieces
+//
+// squares are numbered the same way as the rest of chessMoves, 0 is the top left
+// corner of the board (a8) and 63 the bottom right (h1), square = file + 8 * rank.
+//
+// for every square we keep the mask of the squares whose occupancy can change
+// the attack set (the board edges never can, so they are left out), a magic
+// multiplier that maps every subset of that mask to a unique index, and an
+// offset into one shared attack table per piece type. looking up the attacks
+// of a slider is then a single and, multiply, shift and load.
+//
+// on x86-64 there is a second backend that indexes its own tables with the
+// BMI2 pext instruction instead of the multiply, picked at startup from cpuid.
+// both sit behind rookAttacks / bishopAttacks / queenAttacks.
+namespace chessMoves {
+
+struct magicEntry
+{
+    uint64_t mask   {0};
+    uint64_t magic  {0};
+    uint32_t offset {0};
+    uint32_t shift  {0};
+
+    std::size_t index(uint64_t occupied) const {
+        return offset + static_cast<std::size_t>(((occupied & mask) * magic) >> shift);
+    }
+};
+
+// sum over all squares of 2^popcount(mask), the size of a table with no
+// sharing between squares
+constexpr std::size_t rookAttackTableSize   = 102400;
+constexpr std::size_t bishopAttackTableSize = 5248;
+
+struct rayDirection
+{
+    int dx;
+    int dy;
+};
+
+constexpr std::array<rayDirection, 4> rookDirections   {{ {1, 0}, {-1, 0}, {0, 1}, {0, -1} }};
+constexpr std::array<rayDirection, 4> bishopDirections {{ {1, 1}, {1, -1}, {-1, 1}, {-1, -1} }};
+
+// walks each ray square by square until it runs off the board or hits a piece,
+// the blocking square is included in the attack set. only used to fill the tables.
+inline uint64_t
+slidingAttacksByRays(int place, uint64_t occupied, const std::array<rayDirection, 4>& directions)
+{
+    uint64_t attacked_squares = 0;
+    int rank = place / 8;
+    int file = place % 8;
+
+    for (const rayDirection& d : directions) {
+        for (int r = rank + d.dy, f = file + d.dx; r >= 0 && r <= 7 && f >= 0 && f <= 7; r += d.dy, f += d.dx) {
+            uint64_t looking_at = 1ULL << (f + 8 * r);
+            attacked_squares |= looking_at;
+            if (looking_at & occupied) {
+                break;
+            }
+        }
+    }
+    return attacked_squares;
+}
+
+// the squares that matter for blocking, the ray without its final square on the edge
+inline uint64_t
+relevantOccupancyMask(int place, const std::array<rayDirection, 4>& directions)
+{
+    uint64_t mask = 0;
+    int rank = place / 8;
+    int file = place % 8;
+
+    for (const rayDirection& d : directions) {
+        for (int r = rank + d.dy, f = file + d.dx;
+             r + d.dy >= 0 && r + d.dy <= 7 && f + d.dx >= 0 && f + d.dx <= 7;
+             r += d.dy, f += d.dx) {
+            mask |= 1ULL << (f + 8 * r);
+        }
+    }
+    return mask;
+}
+
+// multipliers found offline with a random search over sparse 64 bit numbers,
+// each one maps every subset of its square's mask to a distinct slot (or to a
+// slot holding the same attack set) using exactly popcount(mask) index bits
+constexpr std::array<uint64_t, 64> rookMagicNumbers {{
+    0x1080004008801020ULL, 0x0840092002c03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000a001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021d00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000a0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000a00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040a00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xc100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000a0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040a00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04c1002414824001ULL, 0x020020000b001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084c0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+}};
+
+constexpr std::array<uint64_t, 64> bishopMagicNumbers {{
+    0x10102002004a1420ULL, 0x8020040400584008ULL, 0x10510800811201c8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200a02020ULL,
+    0x1500241990010e00ULL, 0x8001200182020a40ULL, 0x40004101030b0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020a00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006e080100c3040ULL, 0x0501044a11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422c012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xa010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802a02020000b098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488a00ULL,
+    0x2000081104004040ULL, 0x4c8e029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008a0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4a1500401041004aULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800b62048ULL, 0x0000810400c44420ULL, 0x00080400440c0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810d00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL,
+}};
+
+template<std::size_t TableSize>
+struct magicAttackTable
+{
+    std::array<magicEntry, 64> entries {};
+    std::array<uint64_t, TableSize> attacks {};
+
+    magicAttackTable(const std::array<rayDirection, 4>& directions, const std::array<uint64_t, 64>& magics) {
+        uint32_t offset = 0;
+
+        for (int place = 0; place < 64; ++place) {
+            magicEntry& entry = entries[place];
+            entry.mask   = relevantOccupancyMask(place, directions);
+            entry.magic  = magics[place];
+            entry.shift  = static_cast<uint32_t>(64 - __builtin_popcountll(entry.mask));
+            entry.offset = offset;
+
+            std::size_t size = 1ULL << (64 - entry.shift);
+            if (offset + size > TableSize) {
+                throw std::logic_error("magic attack table is too small for the relevant occupancy masks");
+            }
+
+            // enumerate every subset of the mask with the carry-rippler trick
+            uint64_t subset = 0;
+            do {
+                uint64_t reference = slidingAttacksByRays(place, subset, directions);
+                uint64_t& slot = attacks[entry.index(subset)];
+                if (slot != 0 && slot != reference) {
+                    throw std::logic_error("magic number collision while filling the slider attack table");
+                }
+                slot = reference;
+                subset = (subset - entry.mask) & entry.mask;
+            } while (subset != 0);
+
+            offset += static_cast<uint32_t>(size);
+        }
+    }
+
+    uint64_t lookup(int place, uint64_t occupied) const {
+        return attacks[entries[place].index(occupied)];
+    }
+};
+
+#ifdef CHESS_PEXT_BACKEND
+// pext(occupied, mask) packs the relevant occupancy bits into a dense index,
+// so no multiplier is needed and no slots are shared between subsets. the
+// carry-rippler walk visits the subsets in increasing order of that packed
+// value, which lets the table be filled without executing pext itself.
+template<std::size_t TableSize>
+struct pextAttackTable
+{
+    std::array<uint64_t, 64> masks {};
+    std::array<uint32_t, 64> offsets {};
+    std::array<uint64_t, TableSize> attacks {};
+
+    explicit pextAttackTable(const std::array<rayDirection, 4>& directions) {
+        uint32_t offset = 0;
+
+        for (int place = 0; place < 64; ++place) {
+            masks[place]   = relevantOccupancyMask(place, directions);
+            offsets[place] = offset;
+
+            uint64_t subset = 0;
+            do {
+                attacks[offset++] = slidingAttacksByRays(place, subset, directions);
+                subset = (subset - masks[place]) & masks[place];
+            } while (subset != 0);
+        }
+    }
+
+    __attribute__((target("bmi2")))
+    uint64_t lookup(int place, uint64_t occupied) const {
+        return attacks[offsets[place] + _pext_u64(occupied, masks[place])];
+    }
+};
+#endif
+
+// squares strictly between two squares that share a rank, file or diagonal,
+// zero for any other pair. used for pin rays and for blocking checks
+struct betweenSquaresTable
+{
+    std::array<std::array<uint64_t, 64>, 64> between {};
+
+    betweenSquaresTable() {
+        for (int a = 0; a < 64; ++a) {
+            for (int b = 0; b < 64; ++b) {
+                uint64_t square_a = 1ULL << a;
+                uint64_t square_b = 1ULL << b;
+                for (const std::array<rayDirection, 4>* directions : {&rookDirections, &bishopDirections}) {
+                    if (a != b && (slidingAttacksByRays(a, 0, *directions) & square_b)) {
+                        between[a][b] = slidingAttacksByRays(a, square_b, *directions) &
+                                        slidingAttacksByRays(b, square_a, *directions);
+                    }
+                }
+            }
+        }
+    }
+};
+
+inline const betweenSquaresTable betweenSquares{};
+
+inline uint64_t
+squaresBetween(int from, int to)
+{
+    return betweenSquares.between[from][to];
+}
+
+enum class SliderBackend : int
+{
+    Magic = 0,
+    Pext
+};
+
+inline bool
+sliderBackendSupported(SliderBackend backend)
+{
+    if (backend == SliderBackend::Magic) {
+        return true;
+    }
+#ifdef CHESS_PEXT_BACKEND
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+inline SliderBackend
+detectSliderBackend()
+{
+    return sliderBackendSupported(SliderBackend::Pext) ? SliderBackend::Pext : SliderBackend::Magic;
+}
+
+inline const char*
+sliderBackendName(SliderBackend backend)
+{
+    return backend == SliderBackend::Pext ? "pext" : "magic";
+}
+
+inline const magicAttackTable<rookAttackTableSize>   rookMagics{rookDirections, rookMagicNumbers};
+inline const magicAttackTable<bishopAttackTableSize> bishopMagics{bishopDirections, bishopMagicNumbers};
+
+#ifdef CHESS_PEXT_BACKEND
+inline const pextAttackTable<rookAttackTableSize>   rookPextTable{rookDirections};
+inline const pextAttackTable<bishopAttackTableSize> bishopPextTable{bishopDirections};
+#endif
+
+// chosen once at startup. a branch on a value that never changes is predicted
+// perfectly, and unlike a function pointer it keeps the magic path inlinable
+inline SliderBackend activeSliderBackend = detectSliderBackend();
+
+// returns false and keeps the current backend if the cpu cannot run the requested one
+inline bool
+setSliderBackend(SliderBackend backend)
+{
+    if (!sliderBackendSupported(backend)) {
+        return false;
+    }
+    activeSliderBackend = backend;
+    return true;
+}
+
+// attack sets of a single slider standing on place, occupied is every piece on
+// the board. the first blocker in each direction is included whatever its colour
+inline uint64_t
+rookAttacks(int place, uint64_t occupied)
+{
+#ifdef CHESS_PEXT_BACKEND
+    if (activeSliderBackend == SliderBackend::Pext) {
+        return rookPextTable.lookup(place, occupied);
+    }
+#endif
+    return rookMagics.lookup(place, occupied);
+}
+
+inline uint64_t
+bishopAttacks(int place, uint64_t occupied)
+{
+#ifdef CHESS_PEXT_BACKEND
+    if (activeSliderBackend == SliderBackend::Pext) {
+        return bishopPextTable.lookup(place, occupied);
+    }
+#endif
+    return bishopMagics.lookup(place, occupied);
+}
+
+inline uint64_t
+queenAttacks(int place, uint64_t occupied)
+{
+    return rookAttacks(place, occupied) | bishopAttacks(place, occupied);
+}
+}
@@ -0,0 +1,84 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include "sliderAttacks.hpp"
+
+#pragma once
+
+namespace chessMoves {
+
+struct sliderBenchmarkResult
+{
+    SliderBackend backend;
+    double nanosecondsPerLookup;
+    uint64_t checksum; // sum of every lookup, stops the loop being optimised out
+};
+
+// times rook + bishop lookups over a fixed set of pseudo random occupancies,
+// long enough to be dominated by the lookups rather than the timer
+inline sliderBenchmarkResult
+timeSliderBackend(SliderBackend backend, std::size_t rounds = 2000)
+{
+    constexpr std::size_t samples = 1024;
+    std::array<uint64_t, samples> occupancies {};
+    std::array<int, samples> places {};
+
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    for (std::size_t i = 0; i < samples; ++i) {
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        uint64_t r = seed * 2685821657736338717ULL;
+        occupancies[i] = r & (r >> 7) & (r << 3);
+        places[i] = static_cast<int>(r >> 58);
+    }
+
+    SliderBackend previous = activeSliderBackend;
+    setSliderBackend(backend);
+
+    uint64_t sink = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < samples; ++i) {
+            // feed the previous result back in so the loads cannot be overlapped away
+            uint64_t occupied = occupancies[i] ^ (sink & 1);
+            sink += rookAttacks(places[i], occupied) ^ bishopAttacks(places[i], occupied);
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    activeSliderBackend = previous;
+
+    std::chrono::duration<double, std::nano> elapsed = endTime - startTime;
+    return {backend, elapsed.count() / static_cast<double>(rounds * samples * 2), sink};
+}
+
+// reports every backend the cpu supports and returns the fastest. does not
+// change the active backend, call setSliderBackend with the result to use it
+inline SliderBackend
+benchmarkSliderBackends(std::ostream& out = std::cout)
+{
+    sliderBenchmarkResult best = timeSliderBackend(SliderBackend::Magic);
+    out << "slider backend " << sliderBackendName(best.backend) << " : "
+        << best.nanosecondsPerLookup << " ns per lookup\n";
+
+    if (sliderBackendSupported(SliderBackend::Pext)) {
+        sliderBenchmarkResult pext = timeSliderBackend(SliderBackend::Pext);
+        out << "slider backend " << sliderBackendName(pext.backend) << " : "
+            << pext.nanosecondsPerLookup << " ns per lookup\n";
+        if (pext.checksum != best.checksum) {
+            out << "slider backends disagree, keeping " << sliderBackendName(best.backend) << "\n";
+        } else if (pext.nanosecondsPerLookup < best.nanosecondsPerLookup) {
+            best = pext;
+        }
+    } else {
+        out << "slider backend pext : not supported on this cpu\n";
+    }
+
+    out << "fastest slider backend : " << sliderBackendName(best.backend)
+        << " (selected at startup : " << sliderBackendName(activeSliderBackend) << ")\n";
+    return best.backend;
+}
+}
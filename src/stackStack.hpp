@@ -1,6 +1,9 @@
 #include <algorithm>
 #include <array>
 #include <stdexcept>
+
+#pragma once
+
 template<typename T, std::size_t mN>
 struct stackStack
 {
@@ -61,5 +64,5 @@ struct stackStack
             internalArray[i] = transform(internalArray[i]);
         }
         return *this;
-    };
+    }
 };
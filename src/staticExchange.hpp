@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "boardMove.hpp"
+#include "chessBoard.hpp"
+#include "pieceMovements.hpp"
+
+#pragma once
+
+// static exchange evaluation : the material a capture wins or loses once both
+// sides have made every recapture on its square that pays, cheapest piece
+// first, without searching any other move. pins and checks are ignored
+namespace chessSearch {
+
+// indexed by PieceType, the king is worth more than anything it could win
+constexpr std::array<int, 7> seeValues {100, 500, 320, 330, 900, 20000, 0};
+
+// the board's attackers of place from both sides under the given occupancy
+inline uint64_t
+exchangeAttackers(const chessBoard& board, int place, uint64_t occupied)
+{
+    return (chessBoard::attackersOf(place, occupied, board.side(true), true) |
+            chessBoard::attackersOf(place, occupied, board.side(false), false)) & occupied;
+}
+
+// the material the side to move ends up with after move and the best
+// sequence of recaptures, in centipawns. each capture takes the least
+// valuable attacker left, and when it comes off the board the sliders lined
+// up behind it join in. either side may stop capturing once going on would
+// lose material
+inline int
+staticExchange(const chessBoard& board, chessMoves::boardMove move)
+{
+    using chessMoves::MoveFlag;
+    using chessMoves::PieceType;
+
+    bool white = board.isWhiteTurn();
+    int from = move.from();
+    int to = move.to();
+    sideBitboards white_pieces = board.side(true);
+    sideBitboards black_pieces = board.side(false);
+    uint64_t occupied = white_pieces.pieces | black_pieces.pieces;
+    uint64_t diagonal = white_pieces.bishops | white_pieces.queens | black_pieces.bishops | black_pieces.queens;
+    uint64_t straight = white_pieces.rooks | white_pieces.queens | black_pieces.rooks | black_pieces.queens;
+
+    // gains[depth] is what the side making capture number depth wins if the
+    // exchange stopped right after it
+    std::array<int, 32> gains;
+    int depth = 0;
+    PieceType on_square = board.pieceOn(from, white);
+    if (move.flag() == MoveFlag::EnPassant) {
+        gains[0] = seeValues[static_cast<int>(PieceType::Pawn)];
+        occupied ^= 1ULL << (white ? to + 8 : to - 8);
+    } else {
+        gains[0] = move.isCapture() ? seeValues[static_cast<int>(board.pieceOn(to, !white))] : 0;
+    }
+    if (move.isPromotion()) {
+        on_square = move.promotion();
+        gains[0] += seeValues[static_cast<int>(on_square)] - seeValues[static_cast<int>(PieceType::Pawn)];
+    }
+    occupied ^= 1ULL << from;
+
+    uint64_t attackers = exchangeAttackers(board, to, occupied);
+    bool side = !white;
+    while (true) {
+        sideBitboards pieces = side ? white_pieces : black_pieces;
+        uint64_t own = attackers & pieces.pieces;
+        if (!own) {
+            break;
+        }
+
+        std::array<uint64_t, 6> by_value {pieces.pawns, pieces.knights, pieces.bishops, pieces.rooks, pieces.queens, pieces.king};
+        constexpr std::array<PieceType, 6> types {PieceType::Pawn, PieceType::Knight, PieceType::Bishop, PieceType::Rook, PieceType::Queen, PieceType::King};
+        std::size_t cheapest = 0;
+        while (!(own & by_value[cheapest])) {
+            ++cheapest;
+        }
+        // the king may only take last, while the other side has nothing left to recapture with
+        if (types[cheapest] == PieceType::King && (attackers & ~pieces.pieces)) {
+            break;
+        }
+
+        ++depth;
+        gains[depth] = seeValues[static_cast<int>(on_square)] - gains[depth - 1];
+        on_square = types[cheapest];
+        uint64_t attacker = own & by_value[cheapest];
+        occupied ^= attacker & -attacker;
+
+        // x-rays : pieces on the same line behind the one that just captured
+        attackers |= (chessMoves::bishopAttacks(to, occupied) & diagonal) | (chessMoves::rookAttacks(to, occupied) & straight);
+        attackers &= occupied;
+        side = !side;
+    }
+
+    // going back up, each side takes the better of capturing and stopping
+    while (depth > 0) {
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+        --depth;
+    }
+    return gains[0];
+}
+}
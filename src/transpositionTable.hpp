@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "boardMove.hpp"
+
+#pragma once
+
+// the transposition table of the search, shared by every search thread.
+//
+// the table is an array of 64 byte buckets, one cache line each, holding four
+// entries. a position hashes to one bucket and may sit in any of its entries.
+// an entry is two 64 bit words, the data (move, score, depth, bound and age
+// packed together) and the key xored with the data.
+// both words are read and written with relaxed atomics and no lock. when two
+// threads write the same entry at once the words can end up from different
+// stores, the xor then no longer gives back the key and the entry reads as a
+// miss rather than as another position's data.
+namespace chessSearch {
+
+enum class boundType : uint8_t
+{
+    None = 0,
+    Upper,  // the score is at most this, every move failed low
+    Lower,  // the score is at least this, a move failed high
+    Exact
+};
+
+struct ttEntry
+{
+    chessMoves::boardMove move {};
+    int16_t score {0};
+    uint8_t depth {0};
+    boundType bound {boundType::None};
+};
+
+class transpositionTable
+{
+    // data word layout : move 0-15, score 16-31, depth 32-39, bound 40-41,
+    // age 42-47
+    struct slot
+    {
+        std::atomic<uint64_t> check {0};
+        std::atomic<uint64_t> data {0};
+    };
+
+    static constexpr std::size_t slotsPerBucket = 4;
+
+    struct alignas(64) bucket
+    {
+        std::array<slot, slotsPerBucket> slots;
+    };
+
+    static_assert(sizeof(bucket) == 64, "a bucket fills exactly one cache line");
+
+    std::unique_ptr<bucket[]> m_buckets;
+    std::size_t m_bucket_count {0};
+    uint64_t m_index_mask {0};
+    uint8_t m_age {0};
+
+    static uint64_t pack(const ttEntry& entry, uint8_t age) {
+        return static_cast<uint64_t>(entry.move.raw()) |
+               static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) << 16 |
+               static_cast<uint64_t>(entry.depth) << 32 |
+               static_cast<uint64_t>(entry.bound) << 40 |
+               static_cast<uint64_t>(age & 0x3f) << 42;
+    }
+
+    static ttEntry unpack(uint64_t data) {
+        ttEntry entry;
+        entry.move = chessMoves::boardMove::fromRaw(static_cast<uint16_t>(data));
+        entry.score = static_cast<int16_t>(static_cast<uint16_t>(data >> 16));
+        entry.depth = static_cast<uint8_t>(data >> 32);
+        entry.bound = static_cast<boundType>((data >> 40) & 0b11);
+        return entry;
+    }
+
+    static uint8_t ageOf(uint64_t data) {
+        return static_cast<uint8_t>((data >> 42) & 0x3f);
+    }
+
+    bucket& bucketFor(uint64_t key) const {
+        return m_buckets[key & m_index_mask];
+    }
+
+public:
+    explicit transpositionTable(std::size_t megabytes = 16) {
+        resize(megabytes);
+    }
+
+    // the size is rounded down to a power of two buckets, at least one. clears the table
+    void resize(std::size_t megabytes) {
+        std::size_t count = 1;
+        while (count * 2 * sizeof(bucket) <= megabytes * 1024 * 1024) {
+            count *= 2;
+        }
+        m_buckets = std::make_unique<bucket[]>(count);
+        m_bucket_count = count;
+        m_index_mask = count - 1;
+        m_age = 0;
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < m_bucket_count; ++i) {
+            for (slot& s : m_buckets[i].slots) {
+                s.check.store(0, std::memory_order_relaxed);
+                s.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        m_age = 0;
+    }
+
+    // called once before every search, entries from older searches are
+    // replaced first
+    void newSearch() {
+        m_age = static_cast<uint8_t>((m_age + 1) & 0x3f);
+    }
+
+    bool probe(uint64_t key, ttEntry& entry) const {
+        for (const slot& s : bucketFor(key).slots) {
+            uint64_t data = s.data.load(std::memory_order_relaxed);
+            if ((s.check.load(std::memory_order_relaxed) ^ data) == key && data != 0) {
+                entry = unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // an entry for the same position is always updated, keeping its move if the
+    // new one has none. otherwise the entry whose depth is worth least goes,
+    // every search since it was written costs it as much as four plies of depth
+    void store(uint64_t key, const ttEntry& entry) {
+        bucket& b = bucketFor(key);
+        slot* victim = &b.slots[0];
+        int victim_worth = 1 << 30;
+
+        for (slot& s : b.slots) {
+            uint64_t data = s.data.load(std::memory_order_relaxed);
+            if ((s.check.load(std::memory_order_relaxed) ^ data) == key) {
+                victim = &s;
+                break;
+            }
+            int age_distance = (m_age - ageOf(data)) & 0x3f;
+            int worth = static_cast<int>((data >> 32) & 0xff) - 4 * age_distance;
+            if (worth < victim_worth) {
+                victim = &s;
+                victim_worth = worth;
+            }
+        }
+
+        ttEntry stored = entry;
+        if (stored.move.raw() == 0) {
+            uint64_t old = victim->data.load(std::memory_order_relaxed);
+            if ((victim->check.load(std::memory_order_relaxed) ^ old) == key) {
+                stored.move = unpack(old).move;
+            }
+        }
+        uint64_t data = pack(stored, m_age);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+    // starts loading the bucket of a position that is about to be probed
+    void prefetch(uint64_t key) const {
+        __builtin_prefetch(&bucketFor(key));
+    }
+
+    // entries in use per thousand, sampled from the first thousand buckets
+    int hashfull() const {
+        std::size_t sampled = std::min<std::size_t>(1000, m_bucket_count);
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < sampled; ++i) {
+            for (const slot& s : m_buckets[i].slots) {
+                uint64_t data = s.data.load(std::memory_order_relaxed);
+                used += data != 0 && ageOf(data) == m_age;
+            }
+        }
+        return static_cast<int>(used * 1000 / (sampled * slotsPerBucket));
+    }
+
+    std::size_t bucketCount() const {
+        return m_bucket_count;
+    }
+};
+}
@@ -0,0 +1,48 @@
+#include <array>
+#include <cstdint>
+
+#pragma once
+
+// random keys for zobrist hashing, the hash of a position is the xor of the
+// key of every piece on its square, the side to move, the castling rights and
+// the file of the en passant square. generated by the compiler with splitmix64
+// so every build hashes the same way.
+namespace chessMoves {
+
+constexpr uint64_t
+splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+struct zobristKeys
+{
+    // indexed by colour (white 0, black 1) * 6 + PieceType, then square
+    std::array<std::array<uint64_t, 64>, 12> pieceSquare {};
+    // indexed by the four castling flags of chessBoard::State as a number 0-15
+    std::array<uint64_t, 16> castling {};
+    std::array<uint64_t, 8> enPassantFile {};
+    uint64_t whiteTurn {0};
+
+    constexpr zobristKeys() {
+        uint64_t state = 0x5eed0f2c4e55c10eULL;
+        for (std::array<uint64_t, 64>& piece : pieceSquare) {
+            for (uint64_t& key : piece) {
+                key = splitMix64(state);
+            }
+        }
+        for (uint64_t& key : castling) {
+            key = splitMix64(state);
+        }
+        for (uint64_t& key : enPassantFile) {
+            key = splitMix64(state);
+        }
+        whiteTurn = splitMix64(state);
+    }
+};
+
+constexpr zobristKeys zobrist{};
+}
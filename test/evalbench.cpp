@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/chessBoard.hpp"
+#include "../src/nnue.hpp"
+#include "../src/zobrist.hpp"
+
+// positions from a few pseudo random games, the same ones every run
+static std::vector<chessBoard>
+samplePositions(std::size_t count)
+{
+    std::vector<chessBoard> positions;
+    uint64_t state = 0xbe4c4;
+    chessBoard board;
+    while (positions.size() < count) {
+        chessMoves::moveList moves = board.generateMoves();
+        if (moves.empty() || board.halfmoveClock() >= 100) {
+            board = chessBoard();
+            continue;
+        }
+        board = board.playMove(moves[chessMoves::splitMix64(state) % moves.size()]);
+        positions.push_back(board);
+    }
+    return positions;
+}
+
+template<typename Function>
+static void
+report(const std::string& name, uint64_t evaluations, Function&& run)
+{
+    auto start = std::chrono::steady_clock::now();
+    int64_t checksum = run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << " : " << static_cast<uint64_t>(evaluations / elapsed.count()) << " evals/s"
+              << " (checksum " << checksum << ")\n";
+}
+
+// usage : evalbench [weights file] [--positions <n>] [--write-random <file>]
+// compares evaluations per second of the piece-square tables and of the
+// network on every backend the cpu supports. the network is evaluated from
+// scratch and, the way the search uses it, updated by one move from a parent
+// position. without a weights file a network of random weights is used, which
+// is just as fast. --write-random saves such a network and exits
+int main (int argc, char *argv[]) {
+    try {
+        std::string weights;
+        std::size_t count = 2000;
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--positions" && i + 1 < argc) {
+                count = std::stoul(argv[++i]);
+            } else if (argument == "--write-random" && i + 1 < argc) {
+                chessEval::nnueNetwork::random(1)->save(argv[++i]);
+                return 0;
+            } else {
+                weights = argument;
+            }
+        }
+
+        std::unique_ptr<chessEval::nnueNetwork> network = weights.empty() ? chessEval::nnueNetwork::random(1)
+                                                                          : chessEval::nnueNetwork::load(weights);
+        std::vector<chessBoard> positions = samplePositions(count);
+        constexpr int rounds = 20;
+
+        report("piece-square tables", positions.size() * rounds, [&positions]() {
+            int64_t checksum = 0;
+            for (int round = 0; round < rounds; ++round) {
+                for (const chessBoard& board : positions) {
+                    checksum += board.evaluation();
+                }
+            }
+            return checksum;
+        });
+
+        uint64_t children = 0;
+        for (const chessBoard& board : positions) {
+            children += board.generateMoves().size();
+        }
+
+        for (chessEval::NnueBackend backend : {chessEval::NnueBackend::Scalar, chessEval::NnueBackend::Avx2}) {
+            if (!chessEval::setNnueBackend(backend)) {
+                continue;
+            }
+            std::string name = std::string("nnue ") + chessEval::nnueBackendName(backend);
+            chessEval::nnueEvaluator evaluator(*network, positions.front(), 4);
+
+            report(name + " refresh", positions.size() * rounds, [&]() {
+                int64_t checksum = 0;
+                for (int round = 0; round < rounds; ++round) {
+                    for (const chessBoard& board : positions) {
+                        evaluator.reset(board);
+                        checksum += evaluator.evaluate(board);
+                    }
+                }
+                return checksum;
+            });
+
+            report(name + " incremental", children, [&]() {
+                int64_t checksum = 0;
+                for (chessBoard board : positions) {
+                    evaluator.reset(board);
+                    for (chessMoves::boardMove move : board.generateMoves()) {
+                        evaluator.push(board, move);
+                        board.makeMove(move);
+                        checksum += evaluator.evaluate(board);
+                        board.unmakeMove(move);
+                        evaluator.pop();
+                    }
+                }
+                return checksum;
+            });
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "evalbench : " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
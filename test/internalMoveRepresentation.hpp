@@ -108,8 +108,9 @@ struct chessMove
 
     chessMove(const chessMove& move) : 
         piece(move.piece), moveFrom(move.moveFrom), moveTo(move.moveTo), checkStatus(move.checkStatus), 
-        pawnPromotion(move.pawnPromotion), castlingStatus(move.castlingStatus), m_lastPushed(move.m_lastPushed),
-        m_currentSquareAdd(move.m_currentSquareAdd) 
+        pawnPromotion(move.pawnPromotion), castlingStatus(move.castlingStatus), captureStatus(move.captureStatus),
+        promotionStatus(move.promotionStatus), m_lastPushed(move.m_lastPushed),
+        m_currentSquareAdd(move.m_currentSquareAdd), hasMovementCollapsed(move.hasMovementCollapsed) 
     {
         m_squaresPointers = {&moveFrom, &moveTo};
     }
@@ -0,0 +1,585 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "readTextFile.hpp"
+#include "internalMoveRepresentation.hpp"
+#include "pgnScanner.hpp"
+
+#pragma once
+
+// the standard algebraic notation state machine : a character class and a
+// state table that take a game's moves to chessMove values, and the pgn
+// decoding built on it, whole, streamed and on several threads
+
+enum class AlgebraicChessInput : int {
+    FilePosition          = 0,
+    RankPosition          = 1,
+    PromotableChessPiece  = 2,
+    Capture               = 3,
+    Check                 = 4,
+    SpaceOrNewLine        = 5,
+    Promotion             = 6,
+    CastlingOh            = 7,
+    King                  = 8,
+    CheckMate             = 9,
+    CastlingDash          = 10,
+    Invalid               = 11  // any character that has no place in a move
+};
+// this part of the code relates to the state machine
+
+// Files – the board columns, represented by the characters a–h.
+enum class FilePositionSM : int {
+    A = 0, B, C, D, E, F, G, H
+};
+
+// Ranks – the board rows, represented by digits 1–8.
+enum class RankPositionSM : int {
+    One = 0, Two, Three, Four, Five, Six, Seven, Eight
+};
+
+// Chess pieces – note that in standard algebraic notation a pawn is often omitted.
+enum class ChessPieceSM : int {
+    Queen,
+    Rook,
+    Bishop,
+    Knight
+};
+
+enum class CheckOrMateTokenSM : int {
+    Check,
+    Checkmate,
+};
+
+enum class SpaceOrNewLineSM : int {
+    Space,
+    NewLine
+};
+
+enum class CastlingSM : int {
+    Minus,
+    Oh
+};
+
+// the token type of every character, one lookup per character of the game.
+// characters not listed are Invalid
+constexpr std::array<AlgebraicChessInput, 256>
+makeCharToTokenType()
+{
+    std::array<AlgebraicChessInput, 256> table {};
+    table.fill(AlgebraicChessInput::Invalid);
+    // Files (columns) and Ranks (rows)
+    for (char c = 'a'; c <= 'h'; ++c) {
+        table[static_cast<unsigned char>(c)] = AlgebraicChessInput::FilePosition;
+    }
+    for (char c = '1'; c <= '8'; ++c) {
+        table[static_cast<unsigned char>(c)] = AlgebraicChessInput::RankPosition;
+    }
+    // promotable Chess pieces
+    for (char c : {'Q', 'R', 'B', 'N'}) {
+        table[static_cast<unsigned char>(c)] = AlgebraicChessInput::PromotableChessPiece;
+    }
+    table['K']  = AlgebraicChessInput::King;
+    table['x']  = AlgebraicChessInput::Capture;
+    table['+']  = AlgebraicChessInput::Check;
+    table['#']  = AlgebraicChessInput::CheckMate;
+    table[' ']  = AlgebraicChessInput::SpaceOrNewLine;
+    table['\n'] = AlgebraicChessInput::SpaceOrNewLine;
+    table['=']  = AlgebraicChessInput::Promotion;
+    table['O']  = AlgebraicChessInput::CastlingOh;
+    table['-']  = AlgebraicChessInput::CastlingDash;
+    return table;
+}
+
+constexpr std::array<AlgebraicChessInput, 256> charToTokenType = makeCharToTokenType();
+
+enum class S : int {
+    _=0,     // Invalid sequence entered Error                                
+    S=1,     // start              
+    F=2,     // start input file
+    PR=3,    // named piece then rank
+    FR=4,    // start input file, rank
+    P =5,    // chess piece  inputted
+    PC=6,    // named piece then capture
+    PF=7,    // named piece then file 
+    PFR=8,   // named piece then rank
+    CH=9,    // turn ends in check
+    CM=10,   // turn ends in checkmate
+    PX=11,   // Pawn capture
+    PXF=12,  // Pawn capture Inputted file
+    PXFR=13, // Pawn capture inputted File then rank
+    PP1=14,  // state 1 of pawn promotion
+    PP2=15,  // state 2 of pawn promotion
+    CS1=16,  // first castling symbol recieved
+    CS2=17,  // second castling symbol recieved
+    CS3=18,  // third castling symbol recieved, short
+    CS4=19,  // fourth castling symbol recieved
+    CS5=20,  // fith castling symbol recieved, long  
+    PFD=21,  // named piece destination file
+    PFRD=22  // named piece desintation rank
+};
+
+
+constexpr int Num_states = 23;
+constexpr int Num_token_types = 11;
+constexpr int Num_char_classes = Num_token_types + 1; // the token types and Invalid
+
+// this is a beginning but a better way to structure this would be to define a map between states for every input token type and then use constexpr
+// to automatically generate the transition matrix, this way you keep the performance of the transition matrix while having the flexability of a mapping
+// this would make it easier to mkae revisions to the state machine because with this approach you dont need to specify each state transition just the 
+// ones that have some special behavior, you also dont have to add new rows and collums for each new state / input token.
+
+// all games are valid that dont end in the error state, if no other conditions the winner is the last player to make a move. 
+// also a game can end in a draw if repetition, it is possible to decude the maximally specific game moves and if these show a repetition then 
+// the game ends in a draw.
+
+
+// FilePosition          = 0,
+// RankPosition          = 1,
+// PromotableChessPiece  = 2,
+// Capture               = 3,
+// Check                 = 4,
+// SpaceOrNewLine        = 5,
+// Promotion             = 6,
+// CastlingOh            = 7,
+// King                  = 8,
+// CheckMate             = 9,
+// CastlingDash          = 10
+
+
+// row is current state, collumn is token type
+constexpr std::array<std::array<S, Num_token_types>, Num_states> stateTransitionMatrix {{
+//  FPos       RankPos   PromP     Capture   check     S/NL      Prom      ( O )     King      Checkmate ( - )
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // ERR  0
+    {S::F,     S::_,     S::P,     S::_,     S::_,     S::S,     S::_,     S::CS1,   S::P,     S::_,     S::_  }, // S    1
+    {S::_,     S::FR,    S::_,     S::PX,    S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // F    2
+    {S::PFD,   S::_,     S::_,     S::PC,    S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PR   2
+    {S::_ ,    S::_,     S::_,     S::_,     S::CH,    S::S,     S::PP1,   S::_,     S::_,     S::CM ,   S::_  }, // FR   4
+    {S::PF,    S::PR,    S::_,     S::PC,    S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // P    5
+    {S::PFD,   S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PC   6
+    {S::PFD,   S::PFR,   S::_,     S::PC,    S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PF   7
+    {S::PFD,   S::_,     S::_,     S::PC,    S::CH,    S::S,     S::_,     S::_,     S::_,     S::CM,    S::_  }, // PFR  8
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::S  ,   S::_,     S::_,     S::_,     S::_,     S::_  }, // CH   9
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::CM ,   S::_,     S::_,     S::_,     S::_,     S::_  }, // CM   10
+    {S::PXF,   S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PX   11
+    {S::_,     S::PXFR,  S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PXF  12
+    {S::_,     S::_,     S::_,     S::_,     S::CH ,   S::S,     S::PP1,   S::_,     S::_,     S::CM ,   S::_  }, // PXFR 13
+    {S::_,     S::_,     S::PP2,   S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PP1  14
+    {S::_,     S::_,     S::_,     S::_,     S::CH ,   S::S,     S::_,     S::_,     S::_,     S::CM ,   S::_  }, // PP2  15
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::CS2}, // CS1  16
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::CS3,   S::_,     S::_,     S::_  }, // CS2  17
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::S  ,   S::_,     S::_,     S::_,     S::_,     S::CS4}, // CS3  18
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::CS5,   S::_,     S::_,     S::_  }, // CS4  19
+    {S::_,     S::_,     S::_,     S::_,     S::_,     S::S  ,   S::_,     S::_,     S::_,     S::_,     S::_  }, // CS5  20
+    {S::_,     S::PFRD,  S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_,     S::_  }, // PFD  21
+    {S::_,     S::_,     S::_,     S::_,     S::CH,    S::S,     S::_,     S::_,     S::_,     S::CM,    S::_  }  // PFRD 22
+}};
+
+inline std::string
+stateToString(S state)
+{
+    switch (state) {
+        case S::_:     return "ERR (Invalid sequence entered)";
+        case S::S:     return "S (start)";
+        case S::F:     return "F (start input file)";
+        case S::PR:    return "PR (named piece then rank)";
+        case S::FR:    return "FR (start input file, rank)";
+        case S::P:     return "P (chess piece inputted)";
+        case S::PC:    return "PC (named piece then capture)";
+        case S::PF:    return "FD (named piece file)";
+        case S::PFR:   return "FRD (named piece then file, rank)";
+        case S::CH:    return "CH (turn ends in check)";
+        case S::CM:    return "CM (turn ends in checkmate)";
+        case S::PX:    return "PX (pawn capture)";
+        case S::PXF:   return "PXF (inputted file)";
+        case S::PXFR:  return "PXFR (inputted file then rank)";
+        case S::PP1:   return "PP1 (pawn promotion state 1)";
+        case S::PP2:   return "PP2 (pawn promotion state 2)";
+        case S::CS1:   return "CS1 (first castling symbol received)";
+        case S::CS2:   return "CS2 (second castling symbol received)";
+        case S::CS3:   return "CS3 (third castling symbol received, short)";
+        case S::CS4:   return "CS4 (fourth castling symbol received)";
+        case S::CS5:   return "CS5 (fifth castling symbol received, long)";
+        case S::PFD:   return "PFD (named piece destination file)";
+        case S::PFRD:  return "PFRD (named piece desintation rank, file)";
+        default:       return "Unknown state";
+    }
+}
+
+inline std::string
+algebraicInputToString(AlgebraicChessInput ai)
+{
+    switch (ai) {
+        case AlgebraicChessInput::FilePosition         : return "File Position a..h";
+        case AlgebraicChessInput::RankPosition         : return "Rank Position 1..8";
+        case AlgebraicChessInput::PromotableChessPiece : return "Rook | Knight | Bishop | Queen";
+        case AlgebraicChessInput::Capture              : return "Capture symbol   x";
+        case AlgebraicChessInput::Check                : return "Check symbol     +";
+        case AlgebraicChessInput::SpaceOrNewLine       : return "S/NL";
+        case AlgebraicChessInput::Promotion            : return "Promotion symbol =";
+        case AlgebraicChessInput::CastlingOh           : return "Castling symbol  O";
+        case AlgebraicChessInput::King                 : return "The King K";
+        case AlgebraicChessInput::CheckMate            : return "Checkmate symbol #";
+        case AlgebraicChessInput::CastlingDash         : return "Castling symbol  -";
+        case AlgebraicChessInput::Invalid              : return "Invalid symbol";
+        default                                        : return "Unknown AlgebraicChessInput";
+    }
+}
+
+// what a character adds to the move being decoded, the output half of the
+// state machine. every token type has one action, which is only taken when the
+// character does not lead into the error state
+enum class lexAction : uint8_t {
+    None = 0,
+    File,
+    Rank,
+    Piece,
+    Capture,
+    Check,
+    Checkmate,
+    Promotion,
+    PromotionPiece,
+    CastleShort,
+    CastleLong,
+    EndMove
+};
+
+// indexed by token type
+constexpr std::array<lexAction, Num_token_types> tokenActions {{
+    lexAction::File,       // FilePosition
+    lexAction::Rank,       // RankPosition
+    lexAction::Piece,      // PromotableChessPiece
+    lexAction::Capture,    // Capture
+    lexAction::Check,      // Check
+    lexAction::EndMove,    // SpaceOrNewLine
+    lexAction::Promotion,  // Promotion
+    lexAction::None,       // CastlingOh
+    lexAction::Piece,      // King
+    lexAction::Checkmate,  // CheckMate
+    lexAction::None        // CastlingDash
+}};
+
+struct lexTransition {
+    S next;
+    lexAction action;
+};
+
+// stateTransitionMatrix and tokenActions folded into one table at compile
+// time, the next state and the action of every state and character class.
+// a piece letter after = is the promoted piece, and the last O of a castling
+// move says which side it castles to
+constexpr std::array<std::array<lexTransition, Num_char_classes>, Num_states>
+makeLexTable()
+{
+    std::array<std::array<lexTransition, Num_char_classes>, Num_states> table {};
+    for (int state = 0; state < Num_states; ++state) {
+        for (int token = 0; token < Num_token_types; ++token) {
+            S next = stateTransitionMatrix[state][token];
+            lexAction action = next == S::_ ? lexAction::None : tokenActions[token];
+            if (next == S::PP2) {
+                action = lexAction::PromotionPiece;
+            } else if (next == S::CS3) {
+                action = lexAction::CastleShort;
+            } else if (next == S::CS5) {
+                action = lexAction::CastleLong;
+            }
+            table[state][token] = {next, action};
+        }
+        table[state][Num_token_types] = {S::_, lexAction::None};
+    }
+    return table;
+}
+
+constexpr std::array<std::array<lexTransition, Num_char_classes>, Num_states> lexTable = makeLexTable();
+
+static_assert(lexTable[std::to_underlying(S::S)][std::to_underlying(AlgebraicChessInput::FilePosition)].next == S::F,
+              "a file starts a pawn move");
+static_assert(lexTable[std::to_underlying(S::FR)][std::to_underlying(AlgebraicChessInput::SpaceOrNewLine)].action == lexAction::EndMove,
+              "a space after a square ends the move");
+
+// indexed by character, the piece a piece letter names
+constexpr std::array<ChessPieces, 256>
+makeCharToPiece()
+{
+    std::array<ChessPieces, 256> table {};
+    table['R'] = ChessPieces::Rook;
+    table['N'] = ChessPieces::Knight;
+    table['B'] = ChessPieces::Bishop;
+    table['Q'] = ChessPieces::Queen;
+    table['K'] = ChessPieces::King;
+    return table;
+}
+
+constexpr std::array<ChessPieces, 256> charToPiece = makeCharToPiece();
+
+// the move keeps its old value when it cannot take the new information
+template<typename Information>
+inline void pushInformation(chessMove& move, Information information) {
+    std::optional<chessMove> newMove = move.pushNewInformation(information);
+    if (newMove) {
+        move = *newMove;
+    }
+}
+
+// the state machine of decodeChessGame with its state, the move it is
+// building and the moves so far kept between calls, so a game's text may
+// arrive in pieces that end anywhere
+class sanDecoder {
+    S m_state;
+    chessMove m_workingOnChessMove{};
+    std::vector<chessMove> m_gameMoves{};
+
+public:
+    explicit sanDecoder(S initialState = S::S)
+      : m_state(initialState) {}
+
+    // once in the error state the rest of the game is ignored
+    void feed(std::string_view inputString) {
+        if (m_state == S::_) {
+            return;
+        }
+        for (char myC : inputString) {
+            unsigned char c = static_cast<unsigned char>(myC);
+            AlgebraicChessInput tokenType = charToTokenType[c];
+            lexTransition transition = lexTable[std::to_underlying(m_state)][std::to_underlying(tokenType)];
+
+            switch (transition.action) {
+                case lexAction::None:
+                    break;
+                case lexAction::File:
+                    pushInformation(m_workingOnChessMove, filePos{static_cast<uint8_t>(c - 'a')});
+                    break;
+                case lexAction::Rank:
+                    pushInformation(m_workingOnChessMove, rankPos{static_cast<uint8_t>(c - '1')});
+                    break;
+                case lexAction::Piece:
+                    pushInformation(m_workingOnChessMove, chessPieceVal{charToPiece[c]});
+                    break;
+                case lexAction::Capture:
+                    pushInformation(m_workingOnChessMove, CaptureStatus::Capture);
+                    break;
+                case lexAction::Check:
+                    pushInformation(m_workingOnChessMove, CheckStatus::Check);
+                    break;
+                case lexAction::Checkmate:
+                    pushInformation(m_workingOnChessMove, CheckStatus::Checkmate);
+                    break;
+                case lexAction::Promotion:
+                    pushInformation(m_workingOnChessMove, PromotionStatus::Promotion);
+                    break;
+                case lexAction::PromotionPiece:
+                    pushInformation(m_workingOnChessMove, pawnPromotion{charToPiece[c]});
+                    break;
+                case lexAction::CastleShort:
+                    pushInformation(m_workingOnChessMove, CastlingStatus::Short);
+                    break;
+                case lexAction::CastleLong:
+                    pushInformation(m_workingOnChessMove, CastlingStatus::Long);
+                    break;
+                case lexAction::EndMove:
+                    m_gameMoves.push_back(m_workingOnChessMove);
+                    m_workingOnChessMove = {};
+                    break;
+            }
+
+            m_state = transition.next;
+
+            if (m_state == S::_) {
+                break;
+            }
+        }
+    }
+
+    S state() const {
+        return m_state;
+    }
+
+    const std::vector<chessMove>& moves() const {
+        return m_gameMoves;
+    }
+
+    std::vector<chessMove> takeMoves() {
+        return std::move(m_gameMoves);
+    }
+
+    // ready for the next game, the moves' storage is kept
+    void reset(S initialState = S::S) {
+        m_state = initialState;
+        m_workingOnChessMove = {};
+        m_gameMoves.clear();
+    }
+};
+
+inline std::pair<std::vector<chessMove>, S> decodeChessGame(S initialState, std::string_view inputString) {
+    sanDecoder decoder(initialState);
+    decoder.feed(inputString);
+    S finalState = decoder.state();
+    return std::pair(decoder.takeMoves(), finalState);
+};
+
+// every game of a pgn text, each with the state the decoder ended it in. the
+// scanner hands the state machine nothing but the moves
+inline std::vector<std::pair<std::vector<chessMove>, S>> decodePgn(std::string_view pgn) {
+    pgnMoveText moveText = extractMoveText(pgn);
+    std::vector<std::pair<std::vector<chessMove>, S>> games;
+    games.reserve(moveText.games());
+    for (std::size_t i = 0; i < moveText.games(); ++i) {
+        games.push_back(decodeChessGame(S::S, moveText.game(i)));
+    }
+    return games;
+}
+
+// decodes a pgn file of any size chunkBytes at a time, calling
+// onGame(moves, finalState) with every game once its end has been read. the
+// scanner and the state machine carry their state from one chunk to the next,
+// so memory use is one chunk, the moves scanned from it and the moves of the
+// game being decoded however large the file is. returns the number of games
+template<typename GameCallback>
+std::size_t decodePgnStream(const std::string& pgnFile, GameCallback&& onGame, std::size_t chunkBytes = 1 << 20) {
+    std::filesystem::path fullPath = executableRelativePath(pgnFile);
+    std::ifstream file(fullPath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open " + fullPath.string());
+    }
+
+    std::vector<char> chunk(chunkBytes);
+    pgnMoveText moveText;
+    moveText.moves.reserve(chunkBytes);
+    pgnScanner scanner(moveText);
+    sanDecoder decoder;
+    std::size_t games = 0;
+
+    auto decodeScanned = [&]() {
+        std::string_view moves = moveText.moves;
+        std::size_t begin = 0;
+        for (std::size_t end : moveText.gameEnds) {
+            decoder.feed(moves.substr(begin, end - begin));
+            onGame(decoder.moves(), decoder.state());
+            decoder.reset();
+            ++games;
+            begin = end;
+        }
+        // the moves of a game that carries on into the next chunk
+        decoder.feed(moves.substr(begin));
+        moveText.moves.clear();
+        moveText.gameEnds.clear();
+    };
+
+    while (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0) {
+        scanner.scan(std::string_view(chunk.data(), static_cast<std::size_t>(file.gcount())));
+        decodeScanned();
+    }
+    scanner.finish();
+    decodeScanned();
+    return games;
+}
+
+// the text cut into about parts pieces, each starting at a game. a cut is
+// moved forward to the next [Event tag, or failing that to the next tag
+// pair after a blank line, so no game is split between two pieces. a cut
+// after a { with no } since the last cut would be inside a comment, as { }
+// do not nest, and is moved on to the next candidate. a brace inside a
+// quoted tag value, found with the scanner's tag reader, is not counted
+inline std::vector<std::string_view> splitPgnAtGames(std::string_view pgn, std::size_t parts) {
+    auto findCut = [pgn](std::size_t from) {
+        std::size_t cut = pgn.find("\n[Event ", from);
+        if (cut == std::string_view::npos) {
+            cut = pgn.find("\n\n[", from);
+            cut = cut == std::string_view::npos ? cut : cut + 1;
+        }
+        return cut == std::string_view::npos ? pgn.size() : cut + 1;
+    };
+
+    // whether the end of a piece is inside a comment, from its last brace
+    // outside a tag value
+    auto insideComment = [](std::string_view piece) {
+        std::size_t brace = piece.find_last_of("{}");
+        while (brace != std::string_view::npos) {
+            std::size_t line = piece.rfind('\n', brace);
+            line = line == std::string_view::npos ? 0 : line + 1;
+            if (piece[line] != '[' || !insideTagValue(piece.substr(line + 1, brace - line - 1))) {
+                return piece[brace] == '{';
+            }
+            brace = piece.find_last_of("{}", brace - 1);
+        }
+        return false;
+    };
+
+    std::vector<std::string_view> pieces;
+    std::size_t begin = 0;
+    for (std::size_t part = 1; part <= parts && begin < pgn.size(); ++part) {
+        std::size_t end = pgn.size();
+        if (part < parts) {
+            end = findCut(std::max(begin + 1, pgn.size() / parts * part));
+            while (end < pgn.size() && insideComment(pgn.substr(begin, end - begin))) {
+                end = findCut(end);
+            }
+        }
+        pieces.push_back(pgn.substr(begin, end - begin));
+        begin = end;
+    }
+    return pieces;
+}
+
+struct ingestWorkerStats {
+    std::size_t bytes {0};
+    double seconds {0};
+};
+
+struct parallelDecodeResult {
+    std::vector<std::pair<std::vector<chessMove>, S>> games;
+    std::vector<ingestWorkerStats> workers;
+};
+
+// decodePgn on several threads. the text is split at game boundaries into a
+// few pieces per thread, which the threads take in turn so one slow piece
+// does not hold the rest up, and the games come back in the order of the text
+inline parallelDecodeResult decodePgnParallel(std::string_view pgn, unsigned threads, std::size_t piecesPerThread = 4) {
+    threads = std::max(threads, 1u);
+    std::vector<std::string_view> pieces = splitPgnAtGames(pgn, threads * piecesPerThread);
+    std::vector<std::vector<std::pair<std::vector<chessMove>, S>>> pieceGames(pieces.size());
+    std::atomic<std::size_t> nextPiece {0};
+
+    parallelDecodeResult result;
+    result.workers.resize(threads);
+    auto work = [&](unsigned worker) {
+        auto startTime = std::chrono::steady_clock::now();
+        for (std::size_t piece = nextPiece++; piece < pieces.size(); piece = nextPiece++) {
+            pieceGames[piece] = decodePgn(pieces[piece]);
+            result.workers[worker].bytes += pieces[piece].size();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        result.workers[worker].seconds = elapsed.count();
+    };
+
+    std::vector<std::thread> helpers;
+    for (unsigned worker = 1; worker < threads; ++worker) {
+        helpers.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    std::size_t total = 0;
+    for (const auto& games : pieceGames) {
+        total += games.size();
+    }
+    result.games.reserve(total);
+    for (auto& games : pieceGames) {
+        std::move(games.begin(), games.end(), std::back_inserter(result.games));
+    }
+    return result;
+}
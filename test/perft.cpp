@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../src/perft.hpp"
+
+// usage : perft <depth> [fen] [--bulk] [--hash <megabytes>] [--threads <n>]
+// without a fen the standard starting position is used
+//   --bulk  counts the legal moves at the last ply instead of playing them
+//   --hash  caches subtree counts in a hash table of the given size
+//   --threads  counts on n worker threads, 0 for one per hardware thread
+int main (int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage : " << argv[0] << " <depth> [fen] [--bulk] [--hash <megabytes>] [--threads <n>]\n";
+        return 1;
+    }
+
+    try {
+        int depth = std::stoi(argv[1]);
+        std::string fen;
+        chessPerft::perftOptions options;
+        std::unique_ptr<chessPerft::perftHashTable> hashTable;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--bulk") {
+                options.bulkCount = true;
+            } else if (argument == "--hash" && i + 1 < argc) {
+                hashTable = std::make_unique<chessPerft::perftHashTable>(std::stoul(argv[++i]));
+                options.hashTable = hashTable.get();
+            } else if (argument == "--threads" && i + 1 < argc) {
+                options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+                if (options.threads == 0) {
+                    options.threads = std::max(1u, std::thread::hardware_concurrency());
+                }
+            } else {
+                fen = argument;
+            }
+        }
+
+        chessBoard board = fen.empty() ? chessBoard() : chessBoard(fen);
+        chessPerft::perftDivide(board, depth, options);
+    } catch (const std::exception& e) {
+        std::cerr << "perft : " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
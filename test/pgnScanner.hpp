@@ -0,0 +1,476 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CHESS_PGN_SIMD_BACKEND 1
+#endif
+
+#pragma once
+
+// a pre-pass over pgn text that keeps only the san moves, for the move
+// decoding state machine. tag pairs, {} comments, () variations, move
+// numbers, nags, annotation marks and results are dropped, so the state
+// machine sees each move once followed by a single space.
+//
+// the text is classified 32 bytes at a time into three bitmasks, whitespace,
+// brackets with the quotes and backslashes of tag values, and the digits, dots and dollars of move numbers and nags, by
+// whichever of the scalar, sse4.2 and avx2 kernels the cpu runs. the scanner
+// then jumps from one interesting byte to the next with count trailing zeros,
+// so the bytes of a comment or a tag pair are never looked at one by one and
+// a move number or a nag is skipped whole. results, annotation marks and the
+// words that cross a block are left to a scalar pass over the word
+
+enum class PgnScanBackend : int
+{
+    Scalar = 0,
+    Sse42,
+    Avx2
+};
+
+inline bool
+pgnScanBackendSupported(PgnScanBackend backend)
+{
+    if (backend == PgnScanBackend::Scalar) {
+        return true;
+    }
+#ifdef CHESS_PGN_SIMD_BACKEND
+    return backend == PgnScanBackend::Avx2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+inline PgnScanBackend
+detectPgnScanBackend()
+{
+    if (pgnScanBackendSupported(PgnScanBackend::Avx2)) {
+        return PgnScanBackend::Avx2;
+    }
+    return pgnScanBackendSupported(PgnScanBackend::Sse42) ? PgnScanBackend::Sse42 : PgnScanBackend::Scalar;
+}
+
+inline const char*
+pgnScanBackendName(PgnScanBackend backend)
+{
+    switch (backend) {
+        case PgnScanBackend::Avx2  : return "avx2";
+        case PgnScanBackend::Sse42 : return "sse4.2";
+        default                    : return "scalar";
+    }
+}
+
+inline PgnScanBackend activePgnScanBackend = detectPgnScanBackend();
+
+// returns false and keeps the current backend if the cpu cannot run the requested one
+inline bool
+setPgnScanBackend(PgnScanBackend backend)
+{
+    if (!pgnScanBackendSupported(backend)) {
+        return false;
+    }
+    activePgnScanBackend = backend;
+    return true;
+}
+
+constexpr std::size_t pgnBlockSize = 32;
+
+// bit i describes byte i of the block. every byte up to and including the
+// space counts as whitespace, the brackets are [ ] { } ( ) " and \ and
+// numbering is 0-9 . and $
+struct pgnBlockMasks
+{
+    uint32_t space {0};
+    uint32_t brackets {0};
+    uint32_t numbering {0};
+};
+
+namespace pgnKernels {
+
+inline pgnBlockMasks
+classifyScalar(const char* block)
+{
+    pgnBlockMasks masks;
+    for (std::size_t i = 0; i < pgnBlockSize; ++i) {
+        unsigned char c = static_cast<unsigned char>(block[i]);
+        masks.space |= static_cast<uint32_t>(c <= ' ') << i;
+        bool bracket = c == '[' || c == ']' || c == '{' || c == '}' || c == '(' || c == ')' || c == '"' || c == '\\';
+        masks.brackets |= static_cast<uint32_t>(bracket) << i;
+        bool numbering = (c >= '0' && c <= '9') || c == '.' || c == '$';
+        masks.numbering |= static_cast<uint32_t>(numbering) << i;
+    }
+    return masks;
+}
+
+#ifdef CHESS_PGN_SIMD_BACKEND
+// the string compare instructions test 16 bytes against a range for the
+// whitespace, against a set of characters for the brackets and against three
+// ranges for the numbering
+__attribute__((target("sse4.2")))
+inline pgnBlockMasks
+classifySse42(const char* block)
+{
+    const __m128i space_range = _mm_setr_epi8(0, ' ', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i bracket_set = _mm_setr_epi8('[', ']', '{', '}', '(', ')', '"', '\\', 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i numbering_ranges = _mm_setr_epi8('0', '9', '.', '.', '$', '$', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    constexpr int rangeMode = _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_BIT_MASK;
+    constexpr int setMode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+    pgnBlockMasks masks;
+    for (std::size_t half = 0; half < 2; ++half) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * half));
+        uint32_t space = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_cmpestrm(space_range, 2, bytes, 16, rangeMode)));
+        uint32_t brackets = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_cmpestrm(bracket_set, 8, bytes, 16, setMode)));
+        uint32_t numbering = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_cmpestrm(numbering_ranges, 6, bytes, 16, rangeMode)));
+        masks.space |= (space & 0xffff) << (16 * half);
+        masks.brackets |= (brackets & 0xffff) << (16 * half);
+        masks.numbering |= (numbering & 0xffff) << (16 * half);
+    }
+    return masks;
+}
+
+// a byte is whitespace when the unsigned minimum with a space leaves it
+// unchanged, and a digit when the same holds for nine and the byte less '0'.
+// the brackets, the dot and the dollar are compares
+__attribute__((target("avx2")))
+inline pgnBlockMasks
+classifyAvx2(const char* block)
+{
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i space = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, _mm256_set1_epi8(' ')), bytes);
+    __m256i brackets = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(']'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('}'))));
+    brackets = _mm256_or_si256(brackets, _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('(')),
+                                                         _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(')'))));
+    brackets = _mm256_or_si256(brackets, _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')),
+                                                         _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))));
+    __m256i digit_offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8('0'));
+    __m256i numbering = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(digit_offset, _mm256_set1_epi8(9)), digit_offset),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('.')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('$'))));
+    return {static_cast<uint32_t>(_mm256_movemask_epi8(space)), static_cast<uint32_t>(_mm256_movemask_epi8(brackets)),
+            static_cast<uint32_t>(_mm256_movemask_epi8(numbering))};
+}
+#endif
+}
+
+inline pgnBlockMasks
+classifyPgnBlock(const char* block)
+{
+#ifdef CHESS_PGN_SIMD_BACKEND
+    if (activePgnScanBackend == PgnScanBackend::Avx2) {
+        return pgnKernels::classifyAvx2(block);
+    }
+    if (activePgnScanBackend == PgnScanBackend::Sse42) {
+        return pgnKernels::classifySse42(block);
+    }
+#endif
+    return pgnKernels::classifyScalar(block);
+}
+
+// the san moves of every game, each followed by a space. game i is the text
+// from gameEnds[i - 1] (or zero) up to gameEnds[i]. the moves after the last
+// game end belong to a game whose end has not been scanned yet
+struct pgnMoveText
+{
+    std::string moves;
+    std::vector<std::size_t> gameEnds;
+
+    std::size_t games() const {
+        return gameEnds.size();
+    }
+
+    std::string_view game(std::size_t index) const {
+        std::size_t begin = index == 0 ? 0 : gameEnds[index - 1];
+        return std::string_view(moves).substr(begin, gameEnds[index] - begin);
+    }
+};
+
+// follows a tag pair from the byte after its [, so a ] inside a quoted value
+// such as [Event "Cup [round 2]"] does not end it. a backslash escapes the
+// byte right after it in a value. fed every " \ and ] of the tag, with
+// skip called for any other byte, or fed every byte
+struct pgnTagReader
+{
+    bool inString {false};
+    bool escaped {false};
+
+    // true at the ] that ends the tag
+    bool feed(char c) {
+        if (escaped) {
+            escaped = false;
+            return false;
+        }
+        if (inString) {
+            if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+            return false;
+        }
+        if (c == '"') {
+            inString = true;
+        }
+        return c == ']';
+    }
+
+    void skip() {
+        escaped = false;
+    }
+};
+
+// whether the end of text, the start of a tag pair's line after its [, is
+// inside one of the tag's quoted values
+inline bool
+insideTagValue(std::string_view text)
+{
+    pgnTagReader reader;
+    for (char c : text) {
+        if (reader.feed(c)) {
+            return false;
+        }
+    }
+    return reader.inString;
+}
+
+class pgnScanner
+{
+    enum class scanState : uint8_t
+    {
+        Between,          // whitespace between tokens
+        Word,             // inside a move, a move number or a result
+        Tag,              // inside [ ]
+        Comment,          // inside { }
+        Variation,        // inside ( ), which may nest
+        VariationComment  // inside { } inside ( )
+    };
+
+    pgnMoveText& m_output;
+    scanState m_state {scanState::Between};
+    int m_variation_depth {0};
+    pgnTagReader m_tag;
+    std::string m_word;
+    // a game with moves is open until its end is scanned, the caller may
+    // have taken its first moves out of the output already
+    bool m_game_open {false};
+
+    void endGame() {
+        if (m_game_open) {
+            m_output.gameEnds.push_back(m_output.moves.size());
+            m_game_open = false;
+        }
+    }
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // everything that is not a move is dropped here, a move number may be
+    // written against its move as in 1.e4
+    void finishWord(std::string_view word) {
+        if (word == "1-0" || word == "0-1" || word == "1/2-1/2" || word == "*") {
+            endGame();
+            return;
+        }
+        if (word.front() == '$') {
+            return;
+        }
+        if (word == "0-0" || word == "0-0-0") {
+            m_output.moves += word == "0-0" ? "O-O " : "O-O-O ";
+            m_game_open = true;
+            return;
+        }
+        if (isDigit(word.front()) || word.front() == '.') {
+            std::size_t i = 0;
+            while (i < word.size() && isDigit(word[i])) {
+                ++i;
+            }
+            while (i < word.size() && word[i] == '.') {
+                ++i;
+            }
+            word.remove_prefix(i);
+        }
+        while (!word.empty() && (word.back() == '!' || word.back() == '?')) {
+            word.remove_suffix(1);
+        }
+        if (!word.empty()) {
+            m_output.moves += word;
+            m_output.moves += ' ';
+            m_game_open = true;
+        }
+    }
+
+    // the first valid bytes of the block are text, a move or a comment still
+    // open at the end carries on into the next block
+    void scanBlock(const char* block, pgnBlockMasks masks, std::size_t valid) {
+        uint32_t in_range = valid == pgnBlockSize ? ~0u : (1u << valid) - 1;
+        masks.brackets &= in_range;
+        masks.numbering &= in_range;
+        std::size_t position = 0;
+
+        // the bytes from position on
+        auto from = [&position, in_range]() { return in_range & (~0u << position); };
+
+        while (position < valid) {
+            switch (m_state) {
+                case scanState::Between: {
+                    uint32_t start = ~masks.space & from();
+                    if (!start) {
+                        return;
+                    }
+                    position = static_cast<std::size_t>(__builtin_ctz(start));
+                    char c = block[position];
+                    if (masks.brackets & (1u << position)) {
+                        ++position;
+                        if (c == '[') {
+                            // a tag pair after moves that had no result starts the next game
+                            endGame();
+                            m_tag = {};
+                            m_state = scanState::Tag;
+                        } else if (c == '{') {
+                            m_state = scanState::Comment;
+                        } else if (c == '(') {
+                            m_variation_depth = 1;
+                            m_state = scanState::Variation;
+                        }
+                        break;
+                    }
+                    // a move number such as 12. or 12... and a nag such as $13
+                    // are skipped whole when they end in this block
+                    if (masks.numbering & (1u << position)) {
+                        uint32_t run_end = ~masks.numbering & (~0u << position);
+                        std::size_t stop = run_end ? static_cast<std::size_t>(__builtin_ctz(run_end)) : pgnBlockSize;
+                        bool nag = c == '$' && stop < valid && ((masks.space | masks.brackets) & (1u << stop));
+                        if (nag || block[stop - 1] == '.') {
+                            position = stop;
+                            break;
+                        }
+                    }
+                    m_state = scanState::Word;
+                    break;
+                }
+
+                case scanState::Word: {
+                    uint32_t end = (masks.space | masks.brackets) & from();
+                    std::size_t stop = end ? static_cast<std::size_t>(__builtin_ctz(end)) : valid;
+                    m_word.append(block + position, stop - position);
+                    position = stop;
+                    if (!end) {
+                        return;
+                    }
+                    finishWord(m_word);
+                    m_word.clear();
+                    m_state = scanState::Between;
+                    break;
+                }
+
+                case scanState::Tag: {
+                    uint32_t candidates = masks.brackets & from();
+                    for (; candidates; candidates &= candidates - 1) {
+                        std::size_t place = static_cast<std::size_t>(__builtin_ctz(candidates));
+                        // a byte between the last one fed and this one was not
+                        // a " \ or ], so no escape reaches this far
+                        if (place != position) {
+                            m_tag.skip();
+                        }
+                        position = place + 1;
+                        if (m_tag.feed(block[place])) {
+                            break;
+                        }
+                    }
+                    if (!candidates) {
+                        if (position != valid) {
+                            m_tag.skip();
+                        }
+                        return;
+                    }
+                    m_state = scanState::Between;
+                    break;
+                }
+
+                case scanState::Comment: {
+                    uint32_t candidates = masks.brackets & from();
+                    while (candidates && block[__builtin_ctz(candidates)] != '}') {
+                        candidates &= candidates - 1;
+                    }
+                    if (!candidates) {
+                        return;
+                    }
+                    position = static_cast<std::size_t>(__builtin_ctz(candidates)) + 1;
+                    m_state = scanState::Between;
+                    break;
+                }
+
+                case scanState::Variation:
+                case scanState::VariationComment: {
+                    uint32_t candidates = masks.brackets & from();
+                    if (!candidates) {
+                        return;
+                    }
+                    position = static_cast<std::size_t>(__builtin_ctz(candidates));
+                    char c = block[position++];
+                    if (m_state == scanState::VariationComment) {
+                        if (c == '}') {
+                            m_state = scanState::Variation;
+                        }
+                    } else if (c == '{') {
+                        m_state = scanState::VariationComment;
+                    } else if (c == '(') {
+                        ++m_variation_depth;
+                    } else if (c == ')' && --m_variation_depth == 0) {
+                        m_state = scanState::Between;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+public:
+    explicit pgnScanner(pgnMoveText& output)
+      : m_output(output) {}
+
+    // text may end anywhere, in the middle of a move or a comment, the next
+    // call carries on from there. the moves and game ends scanned so far may
+    // be taken out of the output between calls
+    void scan(std::string_view text) {
+        std::size_t offset = 0;
+        for (; offset + pgnBlockSize <= text.size(); offset += pgnBlockSize) {
+            scanBlock(text.data() + offset, classifyPgnBlock(text.data() + offset), pgnBlockSize);
+        }
+        if (offset < text.size()) {
+            char padded[pgnBlockSize];
+            std::memset(padded, ' ', pgnBlockSize);
+            std::memcpy(padded, text.data() + offset, text.size() - offset);
+            scanBlock(padded, classifyPgnBlock(padded), text.size() - offset);
+        }
+    }
+
+    // the end of the input ends the move being read and the last game
+    void finish() {
+        if (m_state == scanState::Word) {
+            finishWord(m_word);
+            m_word.clear();
+        }
+        m_state = scanState::Between;
+        endGame();
+    }
+};
+
+// the moves of every game in a pgn text
+inline pgnMoveText
+extractMoveText(std::string_view pgn)
+{
+    pgnMoveText output;
+    output.moves.reserve(pgn.size() / 2);
+    pgnScanner scanner(output);
+    scanner.scan(pgn);
+    scanner.finish();
+    return output;
+}
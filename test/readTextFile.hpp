@@ -1,10 +1,16 @@
+#include <cstddef>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits.h>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <utility>
 
 #pragma once
 
@@ -27,15 +33,20 @@ getExecutableDir()
     return std::filesystem::path(getExecutablePath()).parent_path().string();
 }
 
+// Builds the absolute path by joining the executable directory and the
+// relative filename. An absolute filename is returned as it is.
+std::filesystem::path
+executableRelativePath(const std::string& relativeFilename)
+{
+    return std::filesystem::path(getExecutableDir()) / relativeFilename;
+}
+
 // Reads the contents of a file whose path is relative to the executable's
 // directory.
 std::string
 readFromFile(const std::string& relativeFilename)
 {
-    // Build the absolute path by joining the executable directory and the
-    // relative filename.
-    std::filesystem::path fullPath =
-        std::filesystem::path(getExecutableDir()) / relativeFilename;
+    std::filesystem::path fullPath = executableRelativePath(relativeFilename);
 
     std::ifstream file(fullPath, std::ios::binary);
     if (!file) {
@@ -44,3 +55,81 @@ readFromFile(const std::string& relativeFilename)
     return std::string(std::istreambuf_iterator<char>(file),
                        std::istreambuf_iterator<char>());
 }
+
+// A read-only memory mapping of a file whose path is relative to the
+// executable's directory. The text is read straight from the page cache
+// through view() instead of being copied into a string first, and the kernel
+// is told it will be read front to back so it reads ahead and drops pages
+// behind. The view is valid for as long as the mappedFile lives.
+class mappedFile
+{
+    const char* m_data {nullptr};
+    std::size_t m_size {0};
+
+public:
+    explicit mappedFile(const std::string& relativeFilename)
+    {
+        std::filesystem::path fullPath = executableRelativePath(relativeFilename);
+        int descriptor = open(fullPath.c_str(), O_RDONLY);
+        if (descriptor == -1) {
+            throw std::runtime_error("Could not open " + fullPath.string());
+        }
+        struct stat status {};
+        if (fstat(descriptor, &status) == -1) {
+            close(descriptor);
+            throw std::runtime_error("Could not stat " + fullPath.string());
+        }
+        m_size = static_cast<std::size_t>(status.st_size);
+        // mmap of zero bytes fails with EINVAL, an empty file is not mapped
+        // and its view is empty
+        if (m_size > 0) {
+            void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                close(descriptor);
+                throw std::runtime_error("Could not map " + fullPath.string());
+            }
+            madvise(mapping, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(mapping);
+        }
+        // the mapping stays valid once the descriptor is closed
+        close(descriptor);
+    }
+
+    ~mappedFile()
+    {
+        if (m_data) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    mappedFile(const mappedFile&) = delete;
+    mappedFile& operator=(const mappedFile&) = delete;
+
+    // the mapping moves with its owner, the file moved from is left empty
+    mappedFile(mappedFile&& other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    mappedFile& operator=(mappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_data) {
+                munmap(const_cast<char*>(m_data), m_size);
+            }
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(m_data, m_size);
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+};
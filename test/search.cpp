@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "../src/search.hpp"
+
+// searches the position with 1, 2, 4 ... up to max_threads threads under the
+// same limits, each time on a cleared table, and prints how the node rate
+// scales with the thread count
+static void
+printScaling(const chessBoard& board, chessSearch::searchLimits limits, chessSearch::transpositionTable& table,
+             unsigned max_threads, const chessEval::nnueNetwork* network)
+{
+    double single_thread_nps = 0;
+    std::cout << "threads        nodes          nps  speedup  bestmove\n";
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        table.clear();
+        chessSearch::searchIteration result = chessSearch::lazySmpSearch(board, limits, table, threads, {}, network);
+        double nps = result.nodesPerSecond();
+        if (threads == 1) {
+            single_thread_nps = nps;
+        }
+        std::cout << std::setw(7) << threads << std::setw(13) << result.nodes << std::setw(13)
+                  << static_cast<uint64_t>(nps) << std::setw(8) << std::fixed << std::setprecision(2)
+                  << (single_thread_nps > 0 ? nps / single_thread_nps : 0.0) << "x  "
+                  << (result.pv.empty() ? std::string("0000") : chessMoves::moveToString(result.pv.front())) << "\n";
+    }
+}
+
+// usage : search [fen] [--depth <plies>] [--nodes <n>] [--time <milliseconds>] [--hash <megabytes>]
+//                [--threads <n>] [--scaling <max threads>] [--nnue <weights file>]
+// without a fen the standard starting position is used, without a limit the
+// search stops at depth 8. the transposition table defaults to 16 megabytes
+// and the search to one thread. --scaling compares node rates from one thread
+// up to the given count instead of searching once. --nnue evaluates with a
+// network instead of the piece-square tables
+int main (int argc, char *argv[]) {
+    try {
+        std::string fen;
+        chessSearch::searchLimits limits;
+        limits.depth = 8;
+        std::size_t hashMegabytes = 16;
+        unsigned threads = 1;
+        unsigned scalingThreads = 0;
+        std::unique_ptr<chessEval::nnueNetwork> network;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--depth" && i + 1 < argc) {
+                limits.depth = std::stoi(argv[++i]);
+            } else if (argument == "--nodes" && i + 1 < argc) {
+                limits.nodes = std::stoull(argv[++i]);
+                limits.depth = chessSearch::maxPly - 1;
+            } else if (argument == "--time" && i + 1 < argc) {
+                limits.time = std::chrono::milliseconds(std::stoll(argv[++i]));
+                limits.depth = chessSearch::maxPly - 1;
+            } else if (argument == "--hash" && i + 1 < argc) {
+                hashMegabytes = std::stoul(argv[++i]);
+            } else if (argument == "--threads" && i + 1 < argc) {
+                threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (argument == "--nnue" && i + 1 < argc) {
+                network = chessEval::nnueNetwork::load(argv[++i]);
+            } else if (argument == "--scaling" && i + 1 < argc) {
+                scalingThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else {
+                fen = argument;
+            }
+        }
+
+        chessBoard board = fen.empty() ? chessBoard() : chessBoard(fen);
+        chessSearch::transpositionTable table(hashMegabytes);
+        if (scalingThreads > 0) {
+            printScaling(board, limits, table, scalingThreads, network.get());
+            return 0;
+        }
+        chessSearch::searchIteration result =
+            chessSearch::lazySmpSearch(board, limits, table, threads, [](const chessSearch::searchIteration& iteration) {
+                chessSearch::printIteration(iteration);
+            }, network.get());
+        std::cout << "bestmove " << (result.pv.empty() ? std::string("0000") : chessMoves::moveToString(result.pv.front())) << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "search : " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
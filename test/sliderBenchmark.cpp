@@ -0,0 +1,6 @@
+#include "../src/sliderBenchmark.hpp"
+
+int main () {
+    chessMoves::benchmarkSliderBackends();
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../src/nnue.hpp"
+#include "../src/search.hpp"
+
+// a universal chess interface front end, for chess guis and match runners.
+// commands are read on the main thread while the search runs on a worker
+// thread, so uci, isready and stop are answered while it searches. stop sets
+// the flag the search checks at every node, and its bestmove follows as soon
+// as the search unwinds
+class uciEngine
+{
+    chessBoard m_board;
+    chessSearch::transpositionTable m_table {16};
+    unsigned m_threads {1};
+    std::unique_ptr<chessEval::nnueNetwork> m_network;
+
+    std::thread m_worker;
+    std::unique_ptr<chessSearch::searchShared> m_shared;
+
+    // an infinite search that runs out of things to search still waits for
+    // stop before it sends its bestmove
+    std::mutex m_stop_mutex;
+    std::condition_variable m_stop_signal;
+    bool m_stop_requested {false};
+
+    // the worker's info lines and the main thread's answers must not interleave
+    std::mutex m_output_mutex;
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(m_output_mutex);
+        std::cout << line << std::endl;
+    }
+
+    void stopSearch() {
+        if (!m_worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_stop_mutex);
+            m_stop_requested = true;
+        }
+        m_shared->stop.store(true, std::memory_order_relaxed);
+        m_stop_signal.notify_all();
+        m_worker.join();
+    }
+
+    // position [startpos | fen <fen>] [moves <move> ...]
+    void position(std::istringstream& input) {
+        std::string token;
+        input >> token;
+        chessBoard board;
+        if (token == "fen") {
+            std::string fen;
+            while (input >> token && token != "moves") {
+                fen += token + " ";
+            }
+            board = chessBoard(fen);
+        } else if (token == "startpos") {
+            input >> token;
+        } else {
+            throw std::invalid_argument("position needs startpos or fen");
+        }
+        // the moves are made rather than played on copies, so the undo stack
+        // holds the game's positions for repetition detection
+        while (input >> token) {
+            chessSearch::playGameMove(board, board.moveFromString(token));
+        }
+        m_board = board;
+    }
+
+    // go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>]
+    //    [movetime <ms>] [depth <n>] [nodes <n>] [infinite] [ponder]
+    //    [searchmoves <move> ...]
+    // the moves after searchmoves are read past and every root move searched.
+    // a ponder search runs until stop or ponderhit like an infinite one, its
+    // clock limits are for the move after a ponderhit, which this engine
+    // answers at once with what it found while pondering
+    void go(std::istringstream& input) {
+        chessSearch::searchLimits limits;
+        int64_t time_left = -1;
+        int64_t increment = 0;
+        int64_t moves_to_go = 0;
+        int64_t move_time = 0;
+        bool infinite = false;
+        bool white = m_board.isWhiteTurn();
+
+        std::string token;
+        while (input >> token) {
+            if (token == "infinite" || token == "ponder") {
+                infinite = true;
+                continue;
+            }
+            bool numeric = token == "wtime" || token == "btime" || token == "winc" || token == "binc" ||
+                           token == "movestogo" || token == "movetime" || token == "depth" || token == "nodes";
+            if (!numeric) {
+                continue;
+            }
+            int64_t value = 0;
+            if (!(input >> value)) {
+                break;
+            }
+            if ((token == "wtime" && white) || (token == "btime" && !white)) {
+                time_left = value;
+            } else if ((token == "winc" && white) || (token == "binc" && !white)) {
+                increment = value;
+            } else if (token == "movestogo") {
+                moves_to_go = value;
+            } else if (token == "movetime") {
+                move_time = value;
+            } else if (token == "depth") {
+                limits.depth = static_cast<int>(std::clamp<int64_t>(value, 1, chessSearch::maxPly - 1));
+            } else if (token == "nodes") {
+                limits.nodes = static_cast<uint64_t>(value);
+            }
+        }
+
+        if (infinite) {
+            time_left = -1;
+            move_time = 0;
+        }
+        if (move_time > 0) {
+            limits.time = std::chrono::milliseconds(move_time);
+        } else if (time_left >= 0) {
+            // an even share of the clock over the moves still to play, with a
+            // little kept back for the time it takes to send the move
+            int64_t budget = time_left / (moves_to_go > 0 ? moves_to_go : 30) + increment * 3 / 4;
+            budget = std::min(budget, time_left - 50);
+            limits.time = std::chrono::milliseconds(std::max<int64_t>(budget, 1));
+        }
+        bool wait_for_stop = infinite || (move_time == 0 && time_left < 0 && limits.nodes == 0 &&
+                                          limits.depth == chessSearch::maxPly - 1);
+
+        m_shared = std::make_unique<chessSearch::searchShared>();
+        m_stop_requested = false;
+        m_worker = std::thread([this, limits, wait_for_stop, board = m_board]() {
+            chessSearch::searchIteration result = chessSearch::lazySmpSearch(
+                board, limits, m_table, m_threads, *m_shared,
+                [this](const chessSearch::searchIteration& iteration) {
+                    std::ostringstream line;
+                    chessSearch::printIteration(iteration, line);
+                    std::string text = line.str();
+                    text.pop_back();
+                    send(text + " hashfull " + std::to_string(m_table.hashfull()));
+                },
+                m_network.get());
+
+            if (wait_for_stop) {
+                std::unique_lock<std::mutex> lock(m_stop_mutex);
+                m_stop_signal.wait(lock, [this]() { return m_stop_requested; });
+            }
+
+            std::string best = "bestmove " + (result.pv.empty() ? std::string("0000") : chessMoves::moveToString(result.pv[0]));
+            if (result.pv.size() > 1) {
+                best += " ponder " + chessMoves::moveToString(result.pv[1]);
+            }
+            send(best);
+        });
+    }
+
+    // setoption name <name> [value <value>], names may hold spaces
+    void setOption(std::istringstream& input) {
+        std::string token;
+        std::string name;
+        std::string value;
+        input >> token;
+        while (input >> token && token != "value") {
+            name += (name.empty() ? "" : " ") + token;
+        }
+        while (input >> token) {
+            value += (value.empty() ? "" : " ") + token;
+        }
+
+        if (name == "Hash") {
+            m_table.resize(static_cast<std::size_t>(std::clamp(std::stol(value), 1L, 65536L)));
+        } else if (name == "Threads") {
+            m_threads = static_cast<unsigned>(std::clamp(std::stol(value), 1L, 256L));
+        } else if (name == "Clear Hash") {
+            m_table.clear();
+        } else if (name == "EvalFile") {
+            m_network.reset();
+            if (!value.empty() && value != "<empty>") {
+                m_network = chessEval::nnueNetwork::load(value);
+            }
+        } else {
+            throw std::invalid_argument("no option " + name);
+        }
+    }
+
+public:
+    ~uciEngine() {
+        stopSearch();
+    }
+
+    void loop(std::istream& in) {
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream input(line);
+            std::string command;
+            input >> command;
+            try {
+                if (command == "uci") {
+                    send("id name chessClone");
+                    send("id author chessClone contributors");
+                    send("option name Hash type spin default 16 min 1 max 65536");
+                    send("option name Threads type spin default 1 min 1 max 256");
+                    send("option name Clear Hash type button");
+                    send("option name EvalFile type string default <empty>");
+                    send("uciok");
+                } else if (command == "isready") {
+                    send("readyok");
+                } else if (command == "ucinewgame") {
+                    stopSearch();
+                    m_table.clear();
+                } else if (command == "position") {
+                    stopSearch();
+                    position(input);
+                } else if (command == "go") {
+                    stopSearch();
+                    go(input);
+                } else if (command == "stop" || command == "ponderhit") {
+                    stopSearch();
+                } else if (command == "setoption") {
+                    stopSearch();
+                    setOption(input);
+                } else if (command == "quit") {
+                    break;
+                } else if (!command.empty()) {
+                    send("info string unknown command " + command);
+                }
+            } catch (const std::exception& e) {
+                send(std::string("info string ") + e.what());
+            }
+        }
+        stopSearch();
+    }
+};
+
+int main () {
+    std::ios::sync_with_stdio(false);
+    uciEngine engine;
+    engine.loop(std::cin);
+    return 0;
+}
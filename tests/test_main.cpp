@@ -1,9 +1,29 @@
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #define CATCH_CONFIG_MAIN  // This tells Catch2 to provide a main() function.
 #include <catch2/catch_test_macros.hpp>
 #include "../src/stackStack.hpp"
+#include "../src/pieceMovements.hpp"
+#include "../src/chessBoard.hpp"
+#include "../src/perft.hpp"
+#include "../src/nnue.hpp"
+#include "../src/pawnStructure.hpp"
+#include "../src/search.hpp"
+#include "../src/staticExchange.hpp"
+#include "../test/moveDecoding.hpp"
 
 // A helper function to build a default stackStack from an std::array.
 template<typename T, std::size_t mN>
@@ -85,6 +105,997 @@ TEST_CASE("PushItems with another stackStack works correctly", "[stackStack]") {
     REQUIRE_NOTHROW( mainStack.pushItems(anotherStack) );
 }
 
+TEST_CASE("Magic slider attacks match walking the rays", "[sliderAttacks]") {
+    // rook in the top left corner of an empty board sees its whole rank and file
+    REQUIRE( chessMoves::rookAttacks(0, 0) == (0xfeULL | 0x0101010101010100ULL) );
+
+    uint64_t occupied = 0x00ff00240000ff00ULL;
+    for (int place = 0; place < 64; ++place) {
+        REQUIRE( chessMoves::rookAttacks(place, occupied) ==
+                 chessMoves::slidingAttacksByRays(place, occupied, chessMoves::rookDirections) );
+        REQUIRE( chessMoves::bishopAttacks(place, occupied) ==
+                 chessMoves::slidingAttacksByRays(place, occupied, chessMoves::bishopDirections) );
+    }
+}
+
+TEST_CASE("Every supported slider backend gives the same attacks", "[sliderAttacks]") {
+    chessMoves::SliderBackend previous = chessMoves::activeSliderBackend;
+    uint64_t occupied = 0x10a40082c0112400ULL;
+    for (chessMoves::SliderBackend backend : {chessMoves::SliderBackend::Magic, chessMoves::SliderBackend::Pext}) {
+        if (!chessMoves::setSliderBackend(backend)) {
+            continue;
+        }
+        for (int place = 0; place < 64; ++place) {
+            REQUIRE( chessMoves::queenAttacks(place, occupied) ==
+                     (chessMoves::slidingAttacksByRays(place, occupied, chessMoves::rookDirections) |
+                      chessMoves::slidingAttacksByRays(place, occupied, chessMoves::bishopDirections)) );
+        }
+    }
+    chessMoves::setSliderBackend(previous);
+}
+
+TEST_CASE("Queen moves stop at friendly pieces and capture enemies", "[sliderAttacks]") {
+    uint64_t queen    = 1ULL << 27;
+    uint64_t friendly = queen | (1ULL << 29);
+    uint64_t enemy    = 1ULL << 11;
+    uint64_t moves    = chessMoves::queenMove(queen, enemy, friendly);
+    REQUIRE( (moves & friendly) == 0 );
+    REQUIRE( (moves & enemy) == enemy );
+    REQUIRE( (moves & (1ULL << 28)) != 0 );
+    REQUIRE( (moves & (1ULL << 30)) == 0 );
+    REQUIRE( (moves & (1ULL << 3)) == 0 );
+}
+
 TEST_CASE("test individual pawn moves") {
-    uint64_t blackPawn1 = 
+    // black pawn on e7 with nothing in front can push one or two squares
+    uint64_t blackPawn1 = 1ULL << 12;
+    REQUIRE( chessMoves::blackPawnMove(blackPawn1, 0, blackPawn1) == ((1ULL << 20) | (1ULL << 28)) );
+
+    // a piece on e6 blocks both pushes, enemies on d6 and f6 can be captured
+    uint64_t blocker = 1ULL << 20;
+    uint64_t enemies = (1ULL << 19) | (1ULL << 21);
+    REQUIRE( chessMoves::blackPawnMove(blackPawn1, enemies | blocker, blackPawn1) == enemies );
+
+    // white a pawn on its start square cannot capture around the board edge
+    uint64_t whitePawn1 = 1ULL << 48;
+    uint64_t hFileEnemy = 1ULL << 47;
+    REQUIRE( chessMoves::whitePawnMove(whitePawn1, hFileEnemy, whitePawn1) == ((1ULL << 40) | (1ULL << 32)) );
+}
+
+TEST_CASE("Knight and king moves do not wrap around the board", "[leaperAttacks]") {
+    uint64_t hFileKnight = 1ULL << 15;
+    REQUIRE( chessMoves::knightMove(hFileKnight, 0, hFileKnight) == ((1ULL << 5) | (1ULL << 21) | (1ULL << 30)) );
+
+    uint64_t aFileKing = 1ULL << 32;
+    uint64_t friendly  = aFileKing | (1ULL << 24);
+    REQUIRE( chessMoves::kingMove(aFileKing, 0, friendly) == ((1ULL << 25) | (1ULL << 33) | (1ULL << 40) | (1ULL << 41)) );
+}
+
+TEST_CASE("Legal move counts of reference positions", "[moveGeneration]") {
+    REQUIRE( chessBoard().generateMoves().size() == 20 );
+    // many castling, pin and en passant possibilities
+    REQUIRE( chessBoard("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1").generateMoves().size() == 48 );
+    // promotions with and without capture
+    REQUIRE( chessBoard("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1").generateMoves().size() == 6 );
+}
+
+TEST_CASE("En passant that exposes the king along the rank is illegal", "[moveGeneration]") {
+    // the b5 pawn may not take c6 en passant, the rook on h5 would then see the king on a5
+    chessBoard board("8/8/8/KPp4r/8/8/8/7k w - c6 0 1");
+    chessMoves::moveList moves = board.generateMoves();
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        REQUIRE( moves[i].flag() != chessMoves::MoveFlag::EnPassant );
+    }
+}
+
+TEST_CASE("A pinned piece only moves along its pin and double check only allows king moves", "[moveGeneration]") {
+    // the e2 rook is pinned by the e8 rook, it can move along the e file only
+    chessBoard pinned("4r2k/8/8/8/8/8/4R3/4K3 w - - 0 1");
+    chessMoves::moveList moves = pinned.generateMoves();
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        const chessMoves::boardMove& move = moves[i];
+        if (move.from() == 52) {
+            REQUIRE( move.to() % 8 == 4 );
+        }
+    }
+
+    // knight on f3 and rook on e8 both give check
+    chessBoard doubleCheck("4r2k/8/8/8/8/5n2/8/4K2R w K - 0 1");
+    REQUIRE( doubleCheck.inCheck() );
+    moves = doubleCheck.generateMoves();
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        REQUIRE( moves[i].from() == 60 );
+    }
+}
+
+TEST_CASE("Perft node counts of reference positions", "[perft]") {
+    REQUIRE( chessPerft::perft(chessBoard(), 3) == 8902 );
+    REQUIRE( chessPerft::perft(chessBoard("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"), 2) == 2039 );
+    REQUIRE( chessPerft::perft(chessBoard("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"), 3) == 2812 );
+    REQUIRE( chessPerft::perft(chessBoard("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"), 2) == 1486 );
+}
+
+TEST_CASE("Moves print in coordinate notation", "[perft]") {
+    using chessMoves::boardMove;
+    REQUIRE( chessMoves::moveToString(boardMove{52, 36, chessMoves::MoveFlag::DoublePawnPush}) == "e2e4" );
+    REQUIRE( chessMoves::moveToString(boardMove{12, 4, chessMoves::MoveFlag::Promotion, chessMoves::PieceType::Knight}) == "e7e8n" );
+}
+
+TEST_CASE("Coordinate notation reads back into the legal move", "[uci]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    chessBoard board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    REQUIRE( board.moveFromString("e1g1") == boardMove(60, 62, MoveFlag::CastleRight) );
+    REQUIRE( board.moveFromString("e2a6") == boardMove(52, 16, MoveFlag::Capture) );
+    REQUIRE( chessBoard("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8").moveFromString("d7c8r") ==
+             boardMove(11, 2, MoveFlag::PromotionCapture, chessMoves::PieceType::Rook) );
+    REQUIRE_THROWS_AS( board.moveFromString("e1e3"), std::invalid_argument );
+    REQUIRE_THROWS_AS( board.moveFromString("castle"), std::invalid_argument );
+}
+
+TEST_CASE("Bulk counting and the perft hash table do not change node counts", "[perft]") {
+    chessBoard kiwipete("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    uint64_t expected = 97862;
+
+    REQUIRE( chessPerft::perft(kiwipete, 3, {true, nullptr}) == expected );
+
+    chessPerft::perftHashTable hashTable(1);
+    REQUIRE( chessPerft::perft(kiwipete, 3, {false, &hashTable}) == expected );
+    // the second run is answered from the table
+    REQUIRE( chessPerft::perft(kiwipete, 3, {true, &hashTable}) == expected );
+}
+
+TEST_CASE("The position hash depends on pieces, side to move, castling and en passant", "[perft]") {
+    chessBoard start;
+    REQUIRE( start.hash() == chessBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1").hash() );
+    REQUIRE( start.hash() != chessBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1").hash() );
+    REQUIRE( start.hash() != chessBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Kkq - 0 1").hash() );
+    REQUIRE( chessBoard("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1").hash() != chessBoard("4k3/8/8/3pP3/8/8/8/4K3 w - - 0 1").hash() );
+}
+
+TEST_CASE("Parallel perft matches the serial node count", "[perft]") {
+    chessBoard position4("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    std::ostringstream discard;
+
+    chessPerft::perftOptions options;
+    options.threads = 4;
+    REQUIRE( chessPerft::perftDivide(position4, 4, options, discard).nodes == 422333 );
+
+    chessPerft::perftHashTable hashTable(1);
+    options.bulkCount = true;
+    options.hashTable = &hashTable;
+    REQUIRE( chessPerft::perftDivide(position4, 4, options, discard).nodes == 422333 );
+}
+
+TEST_CASE("Moves pack into 16 bits and the move list is cache aligned", "[moveList]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    using chessMoves::PieceType;
+
+    REQUIRE( sizeof(boardMove) == 2 );
+    REQUIRE( alignof(chessMoves::moveList) == 64 );
+    REQUIRE( chessMoves::moveList::capacity >= 256 );
+
+    boardMove promotion(9, 0, MoveFlag::PromotionCapture, PieceType::Rook);
+    REQUIRE( promotion.from() == 9 );
+    REQUIRE( promotion.to() == 0 );
+    REQUIRE( promotion.flag() == MoveFlag::PromotionCapture );
+    REQUIRE( promotion.promotion() == PieceType::Rook );
+    REQUIRE( promotion.isCapture() );
+    REQUIRE( promotion.isPromotion() );
+
+    boardMove enPassant(28, 21, MoveFlag::EnPassant);
+    REQUIRE( enPassant.flag() == MoveFlag::EnPassant );
+    REQUIRE( enPassant.promotion() == PieceType::None );
+    REQUIRE( enPassant.isCapture() );
+    REQUIRE_FALSE( enPassant.isPromotion() );
+}
+
+TEST_CASE("Knight and pawn generators fill a move list", "[moveList]") {
+    chessBoard start;
+    REQUIRE( start.boardKnightMoves().size() == 4 );
+    REQUIRE( start.boardPawnMoves().size() == 16 );
+
+    // the e5 pawn can push, capture d6 en passant or capture f6
+    chessBoard enPassant("4k3/8/5n2/3pP3/8/8/8/4K3 w - d6 0 1");
+    chessMoves::moveList pawnMoves = enPassant.boardPawnMoves();
+    REQUIRE( pawnMoves.size() == 3 );
+}
+
+TEST_CASE("unmakeMove restores the position makeMove changed", "[makeMove]") {
+    for (const char* fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"}) {
+        chessBoard board(fen);
+        uint64_t hashBefore = board.hash();
+        auto piecesBefore = board.piecePositions();
+
+        chessMoves::moveList moves = board.generateMoves();
+        for (const chessMoves::boardMove& move : moves) {
+            board.makeMove(move);
+            REQUIRE_FALSE( board.isWhiteTurn() );
+            board.unmakeMove(move);
+            REQUIRE( board.hash() == hashBefore );
+            REQUIRE( board.piecePositions() == piecesBefore );
+        }
+    }
+}
+
+TEST_CASE("makeMove handles castling, en passant and promotion", "[makeMove]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    using chessMoves::PieceType;
+
+    chessBoard castle("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    castle.makeMove(boardMove(60, 62, MoveFlag::CastleRight));
+    REQUIRE( castle.hash() == chessBoard("r3k2r/8/8/8/8/8/8/R4RK1 b kq - 1 1").hash() );
+
+    chessBoard enPassant("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+    enPassant.makeMove(boardMove(28, 19, MoveFlag::EnPassant));
+    REQUIRE( enPassant.hash() == chessBoard("4k3/8/3P4/8/8/8/8/4K3 b - - 0 1").hash() );
+
+    chessBoard promotion("1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1");
+    promotion.makeMove(boardMove(8, 1, MoveFlag::PromotionCapture, PieceType::Knight));
+    REQUIRE( promotion.hash() == chessBoard("1N2k3/8/8/8/8/8/8/4K3 b - - 0 1").hash() );
+}
+
+TEST_CASE("The incrementally updated hash matches a full recompute", "[hash]") {
+    chessBoard board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    // walk a few plies down the first moves, covering castles, captures and promotions on the way
+    for (int ply = 0; ply < 3; ++ply) {
+        chessMoves::moveList moves = board.generateMoves();
+        for (const chessMoves::boardMove& move : moves) {
+            board.makeMove(move);
+            REQUIRE( board.hash() == board.computeHash() );
+            board.unmakeMove(move);
+            REQUIRE( board.hash() == board.computeHash() );
+        }
+        board.makeMove(moves[0]);
+    }
+}
+
+TEST_CASE("The incrementally updated evaluation matches a full recompute", "[evaluation]") {
+    chessBoard start;
+    // the starting position is symmetric and has all its material
+    REQUIRE( start.evaluation() == 0 );
+    REQUIRE( start.computeEvaluation().phase == chessEval::maxPhase );
+
+    for (const char* fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}) {
+        chessBoard board(fen);
+        for (int ply = 0; ply < 3; ++ply) {
+            chessMoves::moveList moves = board.generateMoves();
+            for (const chessMoves::boardMove& move : moves) {
+                int before = board.evaluation();
+                board.makeMove(move);
+                int recomputed = board.computeEvaluation().blended();
+                REQUIRE( board.evaluation() == (board.isWhiteTurn() ? recomputed : -recomputed) );
+                board.unmakeMove(move);
+                REQUIRE( board.evaluation() == before );
+            }
+            board.makeMove(moves[0]);
+        }
+    }
+
+    // a side a queen up is winning whoever is to move
+    chessBoard white_queen("4k3/8/8/8/8/8/8/3QK3 w - - 0 1");
+    chessBoard black_to_move("4k3/8/8/8/8/8/8/3QK3 b - - 0 1");
+    REQUIRE( white_queen.evaluation() > 800 );
+    REQUIRE( black_to_move.evaluation() == -white_queen.evaluation() );
+}
+
+TEST_CASE("The incrementally updated pawn hash matches a full recompute", "[evaluation]") {
+    // captures of and by pawns, en passant and promotions all change the pawns
+    for (const char* fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}) {
+        chessBoard board(fen);
+        for (int ply = 0; ply < 3; ++ply) {
+            chessMoves::moveList moves = board.generateMoves();
+            for (const chessMoves::boardMove& move : moves) {
+                uint64_t before = board.pawnHash();
+                board.makeMove(move);
+                REQUIRE( board.pawnHash() == board.computePawnHash() );
+                board.unmakeMove(move);
+                REQUIRE( board.pawnHash() == before );
+            }
+            board.makeMove(moves[0]);
+        }
+    }
+
+    // a knight move leaves the pawns as they were
+    chessBoard start;
+    REQUIRE( start.playMove(start.moveFromString("g1f3")).pawnHash() == start.pawnHash() );
+    REQUIRE( start.playMove(start.moveFromString("e2e4")).pawnHash() != start.pawnHash() );
+}
+
+TEST_CASE("Pawn structure finds passed, isolated, doubled and backward pawns", "[evaluation]") {
+    auto bit = [](const char* square) { return 1ULL << ((square[0] - 'a') + 8 * ('8' - square[1])); };
+
+    // the starting pawns have no weaknesses
+    chessBoard start;
+    chessEval::pawnEntry symmetric = chessEval::analysePawns(start.side(true).pawns, start.side(false).pawns);
+    REQUIRE( symmetric.middlegame == 0 );
+    REQUIRE( symmetric.endgame == 0 );
+    REQUIRE( symmetric.passed[0] == 0 );
+    REQUIRE( symmetric.passed[1] == 0 );
+
+    // a white pawn on d5 with no black pawn on the c, d or e files ahead, and
+    // a black one on a7 with no white pawn on the a or b files ahead
+    chessEval::pawnEntry passed = chessEval::analysePawns(bit("d5") | bit("c4"), bit("a7") | bit("b7"));
+    REQUIRE( passed.passed[0] == bit("d5") );
+    REQUIRE( passed.passed[1] == bit("a7") );
+
+    // a lone pawn is passed and isolated
+    chessEval::pawnEntry isolated = chessEval::analysePawns(bit("a2"), 0);
+    REQUIRE( isolated.middlegame == chessEval::passedMiddlegame[1] + chessEval::isolatedMiddlegame );
+    REQUIRE( isolated.endgame == chessEval::passedEndgame[1] + chessEval::isolatedEndgame );
+
+    // doubled white pawns on c2 and c3 beside a b2 pawn cost the rear one
+    chessEval::pawnEntry single = chessEval::analysePawns(bit("b2") | bit("c3"), bit("b7") | bit("c7"));
+    chessEval::pawnEntry doubled = chessEval::analysePawns(bit("b2") | bit("c2") | bit("c3"), bit("b7") | bit("c7"));
+    REQUIRE( doubled.endgame - single.endgame == chessEval::doubledEndgame );
+
+    // a white d3 pawn behind its c4 and e4 neighbours, with a black pawn on e5
+    // guarding d4, is backward and nothing else is weak
+    chessEval::pawnEntry backward = chessEval::analysePawns(bit("c4") | bit("d3") | bit("e4"), bit("c6") | bit("d6") | bit("e5"));
+    REQUIRE( backward.middlegame == chessEval::backwardMiddlegame );
+    REQUIRE( backward.endgame == chessEval::backwardEndgame );
+
+    // swapping the colours and mirroring the board negates the score
+    chessBoard white_side("4k3/p7/8/3P4/8/2P5/2P5/4K3 w - - 0 1");
+    chessBoard black_side("4k3/2p5/2p5/8/3p4/8/P7/4K3 b - - 0 1");
+    chessEval::pawnHashTable table(64);
+    REQUIRE( chessEval::evaluateWithPawns(white_side, table) == chessEval::evaluateWithPawns(black_side, table) );
+}
+
+TEST_CASE("Network accumulators updated move by move match a rebuild", "[nnue]") {
+    std::unique_ptr<chessEval::nnueNetwork> network = chessEval::nnueNetwork::random(7);
+    for (chessEval::NnueBackend backend : {chessEval::NnueBackend::Scalar, chessEval::NnueBackend::Avx2}) {
+        if (!chessEval::setNnueBackend(backend)) {
+            continue;
+        }
+        // castles, en passant, promotions and king moves on the way
+        for (const char* fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                                "4k3/8/5n2/3pP3/8/8/8/4K3 w - d6 0 1"}) {
+            chessBoard board(fen);
+            chessEval::nnueEvaluator incremental(*network, board, 8);
+            for (int ply = 0; ply < 2; ++ply) {
+                chessMoves::moveList moves = board.generateMoves();
+                for (chessMoves::boardMove move : moves) {
+                    incremental.push(board, move);
+                    board.makeMove(move);
+                    chessEval::nnueEvaluator rebuilt(*network, board, 1);
+                    // king moves included, nothing is left for evaluate to rebuild
+                    REQUIRE( incremental.accumulator().computed == std::array<bool, 2> {true, true} );
+                    REQUIRE( incremental.accumulator().values == rebuilt.accumulator().values );
+                    REQUIRE( incremental.evaluate(board) == rebuilt.evaluate(board) );
+                    board.unmakeMove(move);
+                    incremental.pop();
+                }
+                // a king move first where there is one, so the second ply is
+                // updated from an accumulator push rebuilt
+                chessMoves::boardMove next = moves[0];
+                for (chessMoves::boardMove move : moves) {
+                    if (board.pieceOn(move.from(), board.isWhiteTurn()) == chessMoves::PieceType::King) {
+                        next = move;
+                        break;
+                    }
+                }
+                incremental.push(board, next);
+                board.makeMove(next);
+            }
+        }
+    }
+    chessEval::setNnueBackend(chessEval::detectNnueBackend());
+}
+
+TEST_CASE("Every network backend gives the same evaluation", "[nnue]") {
+    std::unique_ptr<chessEval::nnueNetwork> network = chessEval::nnueNetwork::random(11);
+    chessBoard board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    REQUIRE( chessEval::setNnueBackend(chessEval::NnueBackend::Scalar) );
+    int scalar = chessEval::nnueEvaluator(*network, board, 1).evaluate(board);
+    if (chessEval::setNnueBackend(chessEval::NnueBackend::Avx2)) {
+        REQUIRE( chessEval::nnueEvaluator(*network, board, 1).evaluate(board) == scalar );
+    }
+    chessEval::setNnueBackend(chessEval::detectNnueBackend());
+}
+
+TEST_CASE("Networks round trip through a weights file", "[nnue]") {
+    std::unique_ptr<chessEval::nnueNetwork> network = chessEval::nnueNetwork::random(3);
+    std::string path = "nnue_round_trip_test.bin";
+    network->save(path);
+    std::unique_ptr<chessEval::nnueNetwork> loaded = chessEval::nnueNetwork::load(path);
+    REQUIRE( loaded->featureWeights == network->featureWeights );
+    REQUIRE( loaded->layer2Weights == network->layer2Weights );
+    REQUIRE( loaded->outputBias == network->outputBias );
+
+    // a file cut short is rejected
+    {
+        std::ofstream truncated(path, std::ios::binary);
+        truncated.write("CCNN", 4);
+    }
+    REQUIRE_THROWS_AS( chessEval::nnueNetwork::load(path), std::runtime_error );
+    std::remove(path.c_str());
+    REQUIRE_THROWS_AS( chessEval::nnueNetwork::load(path), std::runtime_error );
+
+    // the search can run on the network instead of the piece-square tables
+    chessSearch::searchLimits limits;
+    limits.depth = 3;
+    chessSearch::transpositionTable table(1);
+    chessSearch::searchIteration result = chessSearch::lazySmpSearch(chessBoard(), limits, table, 1, {}, loaded.get());
+    REQUIRE( result.depth == 3 );
+    REQUIRE( chessBoard().isLegal(result.pv.front()) );
+}
+
+TEST_CASE("The search finds a mate in one and reports every iteration", "[search]") {
+    // Ra8 is mate, the black king is boxed in by its own pawns
+    chessBoard board("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    chessSearch::searchLimits limits;
+    limits.depth = 4;
+
+    int iterations = 0;
+    chessSearch::transpositionTable table(1);
+    chessSearch::searcher search(board, limits, table);
+    chessSearch::searchIteration result = search.run([&iterations](const chessSearch::searchIteration&) { ++iterations; });
+
+    REQUIRE( chessMoves::moveToString(result.pv.front()) == "a1a8" );
+    REQUIRE( chessSearch::isMateScore(result.score) );
+    REQUIRE( result.score > 0 );
+    REQUIRE( iterations == result.depth );
+}
+
+TEST_CASE("Quiescence search sees the recapture behind a capture at the horizon", "[search]") {
+    // Qxe5 wins a pawn at depth one, unless dxe5 is looked at as well
+    chessBoard board("4k3/8/3p4/4p3/8/8/1Q6/4K3 w - - 0 1");
+    chessSearch::searchLimits limits;
+    limits.depth = 1;
+    chessSearch::transpositionTable table(1);
+    chessSearch::searcher search(board, limits, table);
+    chessSearch::searchIteration result = search.run();
+
+    REQUIRE( chessMoves::moveToString(result.pv.front()) != "b2e5" );
+    REQUIRE( result.score > 500 );
+}
+
+TEST_CASE("The search finds nearly every pawn structure in its pawn hash table", "[search]") {
+    chessBoard board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    chessSearch::searchLimits limits;
+    limits.depth = 5;
+    chessSearch::transpositionTable table(1);
+    chessSearch::searcher search(board, limits, table);
+    search.run();
+
+    const chessEval::pawnHashTable& pawns = search.pawnTable();
+    REQUIRE( pawns.probes() > 1000 );
+    REQUIRE( pawns.hits() > pawns.probes() * 9 / 10 );
+}
+
+TEST_CASE("The search keeps to its node limit and still returns a move", "[search]") {
+    chessSearch::searchLimits limits;
+    limits.nodes = 5000;
+    chessSearch::transpositionTable table(1);
+    chessSearch::searcher search(chessBoard(), limits, table);
+    chessSearch::searchIteration result = search.run();
+
+    REQUIRE( search.nodes() <= 5000 );
+    REQUIRE_FALSE( result.pv.empty() );
+}
+
+TEST_CASE("Captures and quiets together are exactly the legal moves", "[moveGeneration]") {
+    using chessMoves::GenType;
+    for (const char* fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                            "4k3/8/5n2/3pP3/8/8/8/4K3 w - d6 0 1"}) {
+        chessBoard board(fen);
+        chessMoves::moveList all = board.generateMoves();
+        chessMoves::moveList captures = board.generateMoves(GenType::Captures);
+        chessMoves::moveList quiets = board.generateMoves(GenType::Quiets);
+        REQUIRE( captures.size() + quiets.size() == all.size() );
+        for (chessMoves::boardMove move : captures) {
+            REQUIRE( (move.isCapture() || move.isPromotion()) );
+            REQUIRE( board.isLegal(move) );
+        }
+        for (chessMoves::boardMove move : quiets) {
+            REQUIRE_FALSE( (move.isCapture() || move.isPromotion()) );
+            REQUIRE( board.isLegal(move) );
+        }
+    }
+    // a knight move onto its own pawn and a move of the side not to move
+    chessBoard board;
+    REQUIRE_FALSE( board.isLegal({62, 52, chessMoves::MoveFlag::Quiet}) );
+    REQUIRE_FALSE( board.isLegal({12, 28, chessMoves::MoveFlag::DoublePawnPush}) );
+}
+
+TEST_CASE("The move picker returns every move once, hash move, captures, killers, quiets", "[movePicker]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    chessBoard board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    chessSearch::historyTable history {};
+    // e1g1 castles, a2a3 is a killer, an illegal killer is skipped
+    boardMove hash_move(60, 62, MoveFlag::CastleRight);
+    boardMove killer(48, 40, MoveFlag::Quiet);
+    history[0][49][41] = 500; // b2b3
+    chessSearch::movePicker picker(board, hash_move, {killer, boardMove(62, 52, MoveFlag::Quiet)}, history);
+
+    std::vector<boardMove> picked;
+    boardMove move;
+    while (picker.next(move)) {
+        picked.push_back(move);
+    }
+    REQUIRE( picked.size() == board.generateMoves().size() );
+    for (boardMove legal : board.generateMoves()) {
+        REQUIRE( std::count(picked.begin(), picked.end(), legal) == 1 );
+    }
+
+    std::size_t captures = board.generateMoves(chessMoves::GenType::Captures).size();
+    REQUIRE( picked[0] == hash_move );
+    // Bxa6 takes a bishop for nothing. Qxf6, Qxh3 and the three knight
+    // captures lose material and wait until every quiet move has been tried,
+    // the queen taking the knight first
+    std::size_t bad_captures = 5;
+    std::size_t good_captures = captures - bad_captures;
+    REQUIRE( picked[1] == boardMove(52, 16, MoveFlag::Capture) );
+    for (std::size_t i = 1; i <= good_captures; ++i) {
+        REQUIRE( picked[i].isCapture() );
+        REQUIRE( chessSearch::staticExchange(board, picked[i]) >= 0 );
+    }
+    REQUIRE( picked[good_captures + 1] == killer );
+    REQUIRE( picked[good_captures + 2] == boardMove(49, 41, MoveFlag::Quiet) );
+    REQUIRE( picked[picked.size() - bad_captures] == boardMove(45, 21, MoveFlag::Capture) );
+    for (std::size_t i = picked.size() - bad_captures; i < picked.size(); ++i) {
+        REQUIRE( chessSearch::staticExchange(board, picked[i]) < 0 );
+    }
+}
+
+TEST_CASE("Static exchange evaluation plays out the recaptures, x-rays included", "[see]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    // the pawn on e5 is defended by nothing but the rook on d8, which cannot reach it
+    REQUIRE( chessSearch::staticExchange(chessBoard("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1"),
+                                         boardMove(60, 28, MoveFlag::Capture)) == 100 );
+    // Nxe5 Nxe5 Rxe5 Bxe5 Qxe5 Qxe5, the queens join from behind the rook and the bishop
+    REQUIRE( chessSearch::staticExchange(chessBoard("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1"),
+                                         boardMove(43, 28, MoveFlag::Capture)) == -220 );
+
+    chessBoard kiwipete("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    REQUIRE( chessSearch::staticExchange(kiwipete, boardMove(52, 16, MoveFlag::Capture)) == 330 );
+    REQUIRE( chessSearch::staticExchange(kiwipete, boardMove(45, 21, MoveFlag::Capture)) == 320 - 900 );
+    // a pawn takes a defended pawn, an even trade
+    REQUIRE( chessSearch::staticExchange(kiwipete, boardMove(27, 20, MoveFlag::Capture)) == 0 );
+
+    // the king cannot recapture a defended piece
+    REQUIRE( chessSearch::staticExchange(chessBoard("4k3/8/8/8/8/8/3q4/3RK3 b - - 0 1"),
+                                         boardMove(51, 59, MoveFlag::Capture)) == 500 - 900 );
+    REQUIRE( chessSearch::staticExchange(chessBoard("4k3/3r4/8/8/8/8/3q4/3RK3 b - - 0 1"),
+                                         boardMove(51, 59, MoveFlag::Capture)) == 500 );
+}
+
+TEST_CASE("Lazy smp threads share one table and add up their nodes", "[search]") {
+    chessBoard board("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    chessSearch::searchLimits limits;
+    limits.depth = 4;
+    chessSearch::transpositionTable table(1);
+    chessSearch::searchIteration mate = chessSearch::lazySmpSearch(board, limits, table, 4);
+    REQUIRE( chessMoves::moveToString(mate.pv.front()) == "a1a8" );
+    REQUIRE( chessSearch::isMateScore(mate.score) );
+
+    // every thread stops once the threads together reach the limit, each may
+    // still hold back at most one unshared batch of nodes when it notices
+    chessSearch::searchLimits nodeLimit;
+    nodeLimit.nodes = 20000;
+    table.clear();
+    chessSearch::searchIteration result = chessSearch::lazySmpSearch(chessBoard(), nodeLimit, table, 3);
+    REQUIRE( result.nodes >= 20000 );
+    REQUIRE( result.nodes <= 20000 + 3 * 1024 );
+    REQUIRE_FALSE( result.pv.empty() );
+}
+
+TEST_CASE("Repeated positions are detected from the undo stack", "[search]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    chessBoard board;
+    // Nf3 Nf6 Ng1 Ng8 brings back the starting position
+    for (boardMove move : {boardMove(62, 45, MoveFlag::Quiet), boardMove(6, 21, MoveFlag::Quiet),
+                           boardMove(45, 62, MoveFlag::Quiet), boardMove(21, 6, MoveFlag::Quiet)}) {
+        REQUIRE_FALSE( board.isRepetition() );
+        board.makeMove(move);
+    }
+    REQUIRE( board.isRepetition() );
+}
+
+TEST_CASE("A game longer than the undo stack keeps room for the search and its repetitions", "[search]") {
+    using chessMoves::boardMove;
+    using chessMoves::MoveFlag;
+    chessBoard board;
+    const std::array<boardMove, 4> shuffle {boardMove(62, 45, MoveFlag::Quiet), boardMove(6, 21, MoveFlag::Quiet),
+                                            boardMove(45, 62, MoveFlag::Quiet), boardMove(21, 6, MoveFlag::Quiet)};
+    for (std::size_t i = 0; i < 3 * chessBoard::maxUndoDepth; ++i) {
+        chessSearch::playGameMove(board, shuffle[i % shuffle.size()]);
+        REQUIRE( board.undoDepth() <= chessSearch::gameHistoryLimit );
+    }
+    REQUIRE( board.hash() == board.computeHash() );
+    REQUIRE( board.isRepetition() );
+
+    // the search still has maxPly moves of room above the game
+    for (int ply = 0; ply < chessSearch::maxPly; ++ply) {
+        board.makeMove(shuffle[static_cast<std::size_t>(ply) % shuffle.size()]);
+    }
+    REQUIRE( board.undoDepth() <= chessBoard::maxUndoDepth );
+    for (int ply = chessSearch::maxPly - 1; ply >= 0; --ply) {
+        board.unmakeMove(shuffle[static_cast<std::size_t>(ply) % shuffle.size()]);
+    }
+    REQUIRE( board.isRepetition() );
+}
+
+TEST_CASE("Transposition table entries round trip and other keys of the bucket miss", "[transpositionTable]") {
+    using chessSearch::boundType;
+    using chessSearch::ttEntry;
+    chessSearch::transpositionTable table(1);
+    REQUIRE( table.bucketCount() == 16384 );
+
+    chessMoves::boardMove move(52, 36, chessMoves::MoveFlag::DoublePawnPush);
+    table.store(0x1234, {move, -250, 9, boundType::Lower});
+
+    ttEntry entry;
+    REQUIRE( table.probe(0x1234, entry) );
+    REQUIRE( entry.move == move );
+    REQUIRE( entry.score == -250 );
+    REQUIRE( entry.depth == 9 );
+    REQUIRE( entry.bound == boundType::Lower );
+    // same bucket, different key
+    REQUIRE_FALSE( table.probe(0x1234 + table.bucketCount(), entry) );
+
+    // a store without a move keeps the move already stored for the position
+    table.store(0x1234, {chessMoves::boardMove::fromRaw(0), 40, 10, boundType::Exact});
+    REQUIRE( table.probe(0x1234, entry) );
+    REQUIRE( entry.move == move );
+    REQUIRE( entry.score == 40 );
+}
+
+TEST_CASE("Transposition table replaces the shallowest and oldest entry of a full bucket", "[transpositionTable]") {
+    chessSearch::transpositionTable table(1);
+    uint64_t stride = table.bucketCount();
+    chessMoves::boardMove move(12, 28, chessMoves::MoveFlag::DoublePawnPush);
+
+    for (uint64_t i = 1; i <= 4; ++i) {
+        table.store(i * stride, {move, 0, static_cast<uint8_t>(10 + i), chessSearch::boundType::Exact});
+    }
+    table.store(5 * stride, {move, 0, 1, chessSearch::boundType::Exact});
+
+    chessSearch::ttEntry entry;
+    REQUIRE_FALSE( table.probe(1 * stride, entry) );
+    REQUIRE( table.probe(5 * stride, entry) );
+
+    // after a few searches even the deep entries give way
+    for (int search = 0; search < 10; ++search) {
+        table.newSearch();
+    }
+    table.store(6 * stride, {move, 0, 1, chessSearch::boundType::Exact});
+    REQUIRE( table.probe(6 * stride, entry) );
+    REQUIRE( table.probe(5 * stride, entry) == false );
+}
+
+// the moves of a san game and the state it ends in, every move ended by a space
+static std::pair<std::vector<chessMove>, S> decodeSan(std::string_view game) {
+    return decodeChessGame(S::S, game);
+}
+
+static void requireSquare(const std::optional<chessSquare>& square, char file, char rank) {
+    REQUIRE( square.has_value() );
+    REQUIRE( square->file == static_cast<uint8_t>(file - 'a') );
+    REQUIRE( square->rank == static_cast<uint8_t>(rank - '1') );
+}
+
+TEST_CASE("San moves decode to the piece and squares they name", "[moveDecoding]") {
+    auto [moves, state] = decodeSan("e4 Nf3 Kd2 ");
+    REQUIRE( state == S::S );
+    REQUIRE( moves.size() == 3 );
+
+    // the square of a move without a from square is filled in first
+    REQUIRE( moves[0].piece == ChessPieces::Pawn );
+    requireSquare(moves[0].moveFrom, 'e', '4');
+    REQUIRE_FALSE( moves[0].moveTo.has_value() );
+    REQUIRE( moves[0].captureStatus == CaptureStatus::False );
+    REQUIRE( moves[0].checkStatus == CheckStatus::False );
+
+    REQUIRE( moves[1].piece == ChessPieces::Knight );
+    requireSquare(moves[1].moveFrom, 'f', '3');
+    REQUIRE( moves[2].piece == ChessPieces::King );
+    requireSquare(moves[2].moveFrom, 'd', '2');
+}
+
+TEST_CASE("San captures keep the capture and both squares", "[moveDecoding]") {
+    auto [moves, state] = decodeSan("exd5 Nxe4 Rad1 ");
+    REQUIRE( state == S::S );
+    REQUIRE( moves.size() == 3 );
+
+    REQUIRE( moves[0].piece == ChessPieces::Pawn );
+    REQUIRE( moves[0].captureStatus == CaptureStatus::Capture );
+    REQUIRE( moves[0].moveFrom.has_value() );
+    REQUIRE( moves[0].moveFrom->file == static_cast<uint8_t>(4) );
+    requireSquare(moves[0].moveTo, 'd', '5');
+
+    REQUIRE( moves[1].piece == ChessPieces::Knight );
+    REQUIRE( moves[1].captureStatus == CaptureStatus::Capture );
+    requireSquare(moves[1].moveFrom, 'e', '4');
+
+    // a disambiguating file is not a capture
+    REQUIRE( moves[2].piece == ChessPieces::Rook );
+    REQUIRE( moves[2].captureStatus == CaptureStatus::False );
+    REQUIRE( moves[2].moveFrom->file == static_cast<uint8_t>(0) );
+    requireSquare(moves[2].moveTo, 'd', '1');
+}
+
+TEST_CASE("San promotions name the promoted piece, not the moving one", "[moveDecoding]") {
+    auto [moves, state] = decodeSan("e8=Q bxa1=N+ ");
+    REQUIRE( state == S::S );
+    REQUIRE( moves.size() == 2 );
+
+    REQUIRE( moves[0].piece == ChessPieces::Pawn );
+    REQUIRE( moves[0].promotionStatus == PromotionStatus::Promotion );
+    REQUIRE( moves[0].pawnPromotion == ChessPieces::Queen );
+    requireSquare(moves[0].moveFrom, 'e', '8');
+
+    REQUIRE( moves[1].piece == ChessPieces::Pawn );
+    REQUIRE( moves[1].captureStatus == CaptureStatus::Capture );
+    REQUIRE( moves[1].promotionStatus == PromotionStatus::Promotion );
+    REQUIRE( moves[1].pawnPromotion == ChessPieces::Knight );
+    REQUIRE( moves[1].checkStatus == CheckStatus::Check );
+    requireSquare(moves[1].moveTo, 'a', '1');
+}
+
+TEST_CASE("San check and mate suffixes set the check status", "[moveDecoding]") {
+    auto [moves, state] = decodeSan("Bb5+ Qxf7# ");
+    REQUIRE( moves.size() == 2 );
+    REQUIRE( moves[0].piece == ChessPieces::Bishop );
+    REQUIRE( moves[0].checkStatus == CheckStatus::Check );
+    REQUIRE( moves[1].piece == ChessPieces::Queen );
+    REQUIRE( moves[1].captureStatus == CaptureStatus::Capture );
+    REQUIRE( moves[1].checkStatus == CheckStatus::Checkmate );
+    // nothing may follow a mate
+    REQUIRE( state == S::CM );
+}
+
+TEST_CASE("San castling decodes both sides", "[moveDecoding]") {
+    auto [moves, state] = decodeSan("O-O O-O-O ");
+    REQUIRE( state == S::S );
+    REQUIRE( moves.size() == 2 );
+    REQUIRE( moves[0].castlingStatus == CastlingStatus::Short );
+    REQUIRE( moves[1].castlingStatus == CastlingStatus::Long );
+}
+
+TEST_CASE("San input that is not a move ends in the error state", "[moveDecoding]") {
+    for (std::string_view bad : {"e9 ", "Nf3 Zf6 ", "e4 e4e4 ", "O-O-O-O ", "exe "}) {
+        REQUIRE( decodeSan(bad).second == S::_ );
+    }
+    // the moves before the error are kept and the rest is ignored
+    sanDecoder decoder;
+    decoder.feed("d4 d5 c4 ?? ");
+    decoder.feed("Nc3 ");
+    REQUIRE( decoder.state() == S::_ );
+    REQUIRE( decoder.moves().size() == 3 );
+}
+
+// tag values holding ] and escapes, move numbers, nags, results, comments and
+// variations of every kind, which the scanner drops, around the moves it keeps
+static const std::string_view pgnSample =
+    "[Event \"Cup [round 2]\"]\n[White \"a]b \\\"c\\\" \\\\\"]\n[Result \"1-0\"]\n\n"
+    "1. e4 e5 2.Nf3 d6 3. d4 Bg4 {a weak move} 4. dxe5 Bxf3 5. Qxf3 dxe5 $2 6. Bc4!? Nf6\n"
+    "7. Qb3 Qe7 (7... Qd7 8. Qxb7 {and (not [this]) one} (8. Bxf7+)) 8. Nc3 c6?! 9...b5 $13\n"
+    "10. 0-0-0 O-O 11. e8=Q# 1-0\n\n"
+    "[Event \"Draw\"]\n\n1. h4 a5 1/2-1/2\n";
+
+TEST_CASE("The pgn scanner keeps only the moves and the game ends", "[pgnScanner]") {
+    pgnMoveText moveText = extractMoveText(pgnSample);
+    REQUIRE( moveText.games() == 2 );
+    REQUIRE( moveText.game(0) == "e4 e5 Nf3 d6 d4 Bg4 dxe5 Bxf3 Qxf3 dxe5 Bc4 Nf6 Qb3 Qe7 Nc3 c6 b5 O-O-O O-O e8=Q# " );
+    REQUIRE( moveText.game(1) == "h4 a5 " );
+}
+
+TEST_CASE("Every pgn scan backend classifies bytes and extracts moves as the scalar one does", "[pgnScanner]") {
+    // every byte value at every place of a block
+    std::array<char, 256 + pgnBlockSize> bytes {};
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<char>(i);
+    }
+    // the sample at every alignment to the blocks, so each token is cut by a
+    // block boundary somewhere
+    std::string archive;
+    for (std::size_t shift = 0; shift < pgnBlockSize; ++shift) {
+        archive += std::string(shift, ' ');
+        archive += pgnSample;
+    }
+
+    REQUIRE( setPgnScanBackend(PgnScanBackend::Scalar) );
+    pgnMoveText reference = extractMoveText(archive);
+    REQUIRE( reference.games() == 2 * pgnBlockSize );
+    for (std::size_t shift = 0; shift < pgnBlockSize; ++shift) {
+        REQUIRE( reference.game(2 * shift) == extractMoveText(pgnSample).game(0) );
+    }
+
+    for (PgnScanBackend backend : {PgnScanBackend::Sse42, PgnScanBackend::Avx2}) {
+        if (!setPgnScanBackend(backend)) {
+            continue;
+        }
+        for (std::size_t offset = 0; offset < 256; ++offset) {
+            pgnBlockMasks masks = classifyPgnBlock(bytes.data() + offset);
+            pgnBlockMasks scalar = pgnKernels::classifyScalar(bytes.data() + offset);
+            REQUIRE( masks.space == scalar.space );
+            REQUIRE( masks.brackets == scalar.brackets );
+            REQUIRE( masks.numbering == scalar.numbering );
+        }
+        pgnMoveText moveText = extractMoveText(archive);
+        REQUIRE( moveText.moves == reference.moves );
+        REQUIRE( moveText.gameEnds == reference.gameEnds );
+    }
+    setPgnScanBackend(detectPgnScanBackend());
+}
+
+// a file in the temporary directory holding text, removed with the object
+struct temporaryFile
+{
+    std::filesystem::path path;
+
+    temporaryFile(const std::string& name, std::string_view text)
+      : path(std::filesystem::temp_directory_path() / name) {
+        std::ofstream(path, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    ~temporaryFile() {
+        std::filesystem::remove(path);
+    }
+};
+
+TEST_CASE("A mapped file views the whole file", "[mappedFile]") {
+    temporaryFile file("mappedFileTest.pgn", pgnSample);
+    mappedFile mapped(file.path.string());
+    REQUIRE( mapped.size() == pgnSample.size() );
+    REQUIRE( mapped.view() == pgnSample );
+}
+
+TEST_CASE("An empty file maps to an empty view", "[mappedFile]") {
+    temporaryFile file("mappedFileEmpty.pgn", "");
+    mappedFile mapped(file.path.string());
+    REQUIRE( mapped.size() == 0 );
+    REQUIRE( mapped.view().empty() );
+    REQUIRE( decodePgn(mapped.view()).empty() );
+}
+
+TEST_CASE("Mapping a missing file throws", "[mappedFile]") {
+    std::filesystem::path missing = std::filesystem::temp_directory_path() / "mappedFileMissing.pgn";
+    std::filesystem::remove(missing);
+    REQUIRE_THROWS_AS( mappedFile(missing.string()), std::runtime_error );
+}
+
+TEST_CASE("A mapped file moves its mapping and unmaps it once", "[mappedFile]") {
+    temporaryFile file("mappedFileMove.pgn", pgnSample);
+    temporaryFile other("mappedFileOther.pgn", "1. e4 *");
+
+    mappedFile first(file.path.string());
+    const char* data = first.view().data();
+    mappedFile second(std::move(first));
+    REQUIRE( second.view().data() == data );
+    REQUIRE( second.view() == pgnSample );
+    REQUIRE( first.view().empty() );
+
+    // the target's own mapping is released and the source left empty, so
+    // each mapping is unmapped by exactly one destructor
+    mappedFile third(other.path.string());
+    third = std::move(second);
+    REQUIRE( third.view().data() == data );
+    REQUIRE( second.view().empty() );
+    REQUIRE( second.size() == 0 );
+
+    mappedFile moved = std::move(third);
+    REQUIRE( moved.view() == pgnSample );
+}
+
+static bool sameMove(const chessMove& a, const chessMove& b) {
+    auto square = [](const std::optional<chessSquare>& s) {
+        return s ? std::pair(s->file, s->rank) : std::pair(std::optional<uint8_t>(), std::optional<uint8_t>());
+    };
+    return a.piece == b.piece && square(a.moveFrom) == square(b.moveFrom) && square(a.moveTo) == square(b.moveTo)
+        && a.checkStatus == b.checkStatus && a.pawnPromotion == b.pawnPromotion && a.castlingStatus == b.castlingStatus
+        && a.captureStatus == b.captureStatus && a.promotionStatus == b.promotionStatus;
+}
+
+static bool sameGame(const std::pair<std::vector<chessMove>, S>& a, const std::vector<chessMove>& moves, S state) {
+    return a.second == state && a.first.size() == moves.size()
+        && std::equal(moves.begin(), moves.end(), a.first.begin(), sameMove);
+}
+
+TEST_CASE("Streaming a pgn in chunks of any size decodes what the whole text does", "[moveDecoding]") {
+    std::string pgn;
+    for (std::size_t shift = 0; shift < 8; ++shift) {
+        pgn += std::string(shift, '\n');
+        pgn += pgnSample;
+    }
+    // a last game without a result, ended by the end of the file
+    pgn += "\n[Event \"Unfinished\"]\n\n1. d4 Nf6 2. c4";
+    temporaryFile file("decodePgnStream.pgn", pgn);
+    std::vector<std::pair<std::vector<chessMove>, S>> whole = decodePgn(pgn);
+    REQUIRE( whole.size() == 17 );
+    REQUIRE( whole.back().first.size() == 3 );
+
+    for (std::size_t chunkBytes : {std::size_t {1}, std::size_t {7}, std::size_t {4096}}) {
+        std::size_t game = 0;
+        std::size_t mismatches = 0;
+        std::size_t games = decodePgnStream(file.path.string(), [&](const std::vector<chessMove>& moves, S state) {
+            mismatches += game >= whole.size() || !sameGame(whole[game], moves, state);
+            ++game;
+        }, chunkBytes);
+        REQUIRE( games == whole.size() );
+        REQUIRE( game == whole.size() );
+        REQUIRE( mismatches == 0 );
+    }
+}
+
+TEST_CASE("A pgn is split only between games and decodes the same on any number of threads", "[moveDecoding]") {
+    // games without an Event tag, one of them with a comment that holds a
+    // blank line and a bracket, which must not be taken for the next game
+    std::string pgn = std::string(pgnSample) + "\n[Event \"Sample\"]\n\n1. e4 e5 2. Nf3 Nc6 1-0\n\n";
+    for (int copy = 0; copy < 12; ++copy) {
+        pgn += "[Site \"?\"]\n\n1. d4 d5 *\n\n";
+        pgn += "[Result \"0-1\"]\n\n1. c4 {an English\n\n[not a tag]\n\n[nor this] opening} e5 2. g3 0-1\n\n";
+    }
+    std::vector<std::pair<std::vector<chessMove>, S>> serial = decodePgn(pgn);
+    REQUIRE( serial.size() == 27 );
+
+    for (std::size_t parts = 1; parts <= 64; ++parts) {
+        std::vector<std::string_view> pieces = splitPgnAtGames(pgn, parts);
+        REQUIRE( pieces.size() <= parts );
+        std::size_t offset = 0;
+        std::size_t games = 0;
+        for (std::string_view piece : pieces) {
+            REQUIRE( piece.data() == pgn.data() + offset );
+            if (offset > 0) {
+                bool eventTag = piece.starts_with("[Event ");
+                bool tagAfterBlankLine = piece.starts_with("[") && std::string_view(pgn).substr(offset - 2, 2) == "\n\n";
+                REQUIRE( (eventTag || tagAfterBlankLine) );
+                REQUIRE_FALSE( piece.starts_with("[not a tag]") );
+                REQUIRE_FALSE( piece.starts_with("[nor this]") );
+            }
+            offset += piece.size();
+            games += decodePgn(piece).size();
+        }
+        REQUIRE( offset == pgn.size() );
+        REQUIRE( games == serial.size() );
+    }
+
+    for (unsigned threads = 1; threads <= 4; ++threads) {
+        for (std::size_t piecesPerThread : {std::size_t {1}, std::size_t {4}, std::size_t {16}}) {
+            parallelDecodeResult parallel = decodePgnParallel(pgn, threads, piecesPerThread);
+            REQUIRE( parallel.workers.size() == threads );
+            REQUIRE( parallel.games.size() == serial.size() );
+            for (std::size_t game = 0; game < serial.size(); ++game) {
+                REQUIRE( sameGame(serial[game], parallel.games[game].first, parallel.games[game].second) );
+            }
+        }
+    }
+}
+
+TEST_CASE("A brace inside a tag value does not stop a pgn from being split", "[moveDecoding]") {
+    std::string pgn;
+    for (int copy = 0; copy < 6; ++copy) {
+        pgn += "[Site \"x {\"]\n[Round \"} [{\\\"\"]\n\n1. e4 e5 1-0\n\n";
+    }
+    std::vector<std::string_view> pieces = splitPgnAtGames(pgn, 3);
+    REQUIRE( pieces.size() == 3 );
+    std::size_t games = 0;
+    for (std::string_view piece : pieces) {
+        REQUIRE( piece.starts_with("[Site ") );
+        games += decodePgn(piece).size();
+    }
+    REQUIRE( games == 6 );
+    parallelDecodeResult parallel = decodePgnParallel(pgn, 3, 1);
+    REQUIRE( parallel.games.size() == 6 );
+    for (const auto& game : parallel.games) {
+        REQUIRE( game.second == S::S );
+        REQUIRE( game.first.size() == 2 );
+    }
 }